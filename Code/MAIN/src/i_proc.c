@@ -8,14 +8,18 @@
 #include <LPC17xx.h>
 #include "uart.h"
 #include "uart_polling.h"
+#include "uart_log.h"
+#include "trace.h"
+#include "log_fmt.h"
 #include "k_rtx.h"
 #include "i_proc.h"
 #include "k_process.h"
-#ifdef DEBUG_0
-#include "printf.h"
-#endif
+#include "k_timer.h"
+#include "uart_tx.h"
+#include "uart_rx.h"
 #ifdef DEBUG_HK
 #include <assert.h>
+#include "printf.h"
 #endif
 
 #define BIT(X)(1 << (X))
@@ -24,17 +28,12 @@ extern U32 g_switch_flag;
 extern PCB* gp_current_process;
 extern PCB* get_proc_by_pid(int pid);
 
-volatile uint32_t g_timer_count = 0; // increment every 1 ms
+volatile uint32_t g_timer_count = 0; // increment every 1 ms, wraps after about 49 days
+volatile uint32_t g_timer_epoch = 0; // number of times g_timer_count wrapped
 volatile uint32_t g_bench_timer_count = 0;
 
-ForwardList* delayed_messages; // List of delayed messages
 PCB* timer_proc;
 
-char g_buffer[];
-char* gp_buffer = g_buffer;
-char g_char_in;
-char g_char_out;
-
 
 #ifdef DEBUG_HK
 /**
@@ -114,14 +113,17 @@ uint32_t timer_init(uint8_t n_timer)
 	
 	/* Step 4.1: Prescale Register PR setting
 	   CCLK = 100 MHZ, PCLK = CCLK/4 = 25 MHZ
-	   2*(12499 + 1)*(1/25) * 10^(-6) s = 10^(-3) s = 1 ms
-	   TC (Timer Counter) toggles b/w 0 and 1 every 12500 PCLKs
+	   (24 + 1)*(1/25) * 10^(-6) s = 10^(-6) s = 1 us
+	   TC (Timer Counter) counts microseconds, every 25 PCLKs
 	   see MR setting below
 	*/
-	pTimer->PR = 12499;
+	pTimer->PR = TIMER_PRESCALE_US;
 	
-	/* Step 4.2: MR setting, see section 21.6.7 on pg496 of LPC17xx_UM. */
-	pTimer->MR0 = 1;
+	/* Step 4.2: MR setting, see section 21.6.7 on pg496 of LPC17xx_UM.
+	   TC counts 0..999 then resets, so the tick is still 1 ms
+	   and the TC holds the microseconds into the current tick
+	*/
+	pTimer->MR0 = TIMER_US_PER_TICK - 1;
 	
 	/* Step 4.3: MCR setting, see table 429 on pg496 of LPC17xx_UM.
 	   Interrupt on MR0: when MR0 mathches the value in the TC,
@@ -133,6 +135,7 @@ uint32_t timer_init(uint8_t n_timer)
 	/* Step 4.4: CSMSIS enable timer IRQ */
 	if (n_timer == 0) {
 		g_timer_count = 0;
+		g_timer_epoch = 0;
 		NVIC_EnableIRQ(TIMER0_IRQn);
 	}
 	else {
@@ -154,6 +157,24 @@ uint32_t get_current_time(void)
 	return g_timer_count;
 }
 
+/**
+ * @brief: Combines the tick count with TIMER0's TC into a 64-bit microsecond time that never wraps
+ * NOTE: Must be called with interrupts disabled
+ */
+uint64_t get_monotonic_time_us(void)
+{
+	uint64_t ticks = ((uint64_t)g_timer_epoch << 32) | g_timer_count;
+	uint32_t us = LPC_TIM0->TC;
+	
+	// If the tick is pending, TC already reset for the next tick, so read it again and count the tick
+	if (LPC_TIM0->IR & BIT(0)) {
+		us = LPC_TIM0->TC;
+		ticks++;
+	}
+	
+	return ticks * TIMER_US_PER_TICK + us;
+}
+
 /**
  * Simply returns the benchmark time
  */
@@ -198,7 +219,10 @@ void c_TIMER0_IRQHandler(void)
 	LPC_TIM0->IR = BIT(0); // acknowledge interrupt
 	g_switch_flag = 0;     // Reset the switch flag
 	
-	g_timer_count++; // Increment the time
+	// Increment the time, carrying into the epoch when the millisecond count wraps
+	if (++g_timer_count == 0) {
+		g_timer_epoch++;
+	}
 	
 	cur_proc = gp_current_process;   // Save the actual current process
 	gp_current_process = timer_proc; // Set the timer as the current process
@@ -213,35 +237,8 @@ void c_TIMER0_IRQHandler(void)
  */
 void timer_i_process()
 {
-	MSG_BUF* message;
-	
-	// Insert the envelopes of any received messages into the list of delayed messages
-	while (message = (MSG_BUF*)ki_receive_message(0)) {
-		// Get the pointer to the envelope from the message
-		MSG_ENVELOPE* envelope = (MSG_ENVELOPE*)k_message_to_envelope(message);
-		
-		/* Insert the envelope into the delayed messages list based on the send time.
-		 * The later the send time, the farther to the back of the list the message will be inserted.
-		 */
-		if (empty(delayed_messages) || ((MSG_ENVELOPE*)delayed_messages->front)->send_time > envelope->send_time) {
-			push_front(delayed_messages, (ListNode*)envelope);
-		}
-		else {
-			MSG_ENVELOPE* iter = (MSG_ENVELOPE*)delayed_messages->front;
-			while (iter->next && iter->next->send_time <= envelope->send_time) {
-				iter = iter->next;
-			}
-			// Perform the insertion
-			envelope->next = iter->next;
-			iter->next = envelope;
-		}
-	}
-	
-	// Remove expired messages from the list of delayed messages and send them
-	while (!empty(delayed_messages) && ((MSG_ENVELOPE*)delayed_messages->front)->send_time <= g_timer_count) {
-		MSG_ENVELOPE* envelope = (MSG_ENVELOPE*)pop_front(delayed_messages);
-		k_send_message(envelope->destination_pid, envelope);
-	}
+	// Deliver the messages of the timers that expired (they are kept in order of expiry)
+	fire_expired_timers(g_timer_count);
 }
 
 __asm void TIMER1_IRQHandler(void)
@@ -318,6 +315,8 @@ int uart_irq_init(int n_uart)
 		
 		pUart = (LPC_UART_TypeDef*) LPC_UART0;
 		
+		uart_tx_init();
+		
 	}
 	else if ( n_uart == 1) {
 	
@@ -364,10 +363,11 @@ int uart_irq_init(int n_uart)
 	       see table 278 on pg305 in LPC17xx_UM
 	-----------------------------------------------------
 	    enable Rx and Tx FIFOs, clear Rx and Tx FIFOs
-	Trigger level 0 (1 char per interrupt)
+	Trigger level 2 (8 chars per interrupt). Fewer chars than that
+	are picked up by the character timeout interrupt (CTI)
 	*/
 	
-	pUart->FCR = 0x07;
+	pUart->FCR = 0x87;
 	
 	/* Step 5 was done between step 2 and step 4 a few lines above */
 	
@@ -429,13 +429,54 @@ RESTORE2
 	POP {r4-r11, pc}
 }
 
+/**
+ * @brief: Drains UART0's RX FIFO through the frame receiver or the line discipline
+ */
+void uart_rx_drain(LPC_UART_TypeDef* pUart)
+{
+	U8 line_status;
+	char char_in;
+	
+	/* Reading RBR until the FIFO is empty clears both RDA and CTI */
+	while ((line_status = pUart->LSR) & LSR_RDR) {
+		char_in = pUart->RBR;
+		if (line_status & (LSR_PE | LSR_FE | LSR_BI)) {
+			continue; // Drop characters that arrived corrupted
+		}
+		
+#ifdef DEBUG_0
+		LOG1(LOG_UART_CHAR, char_in);
+#endif // DEBUG_0
+		
+		if (uart_frame_input(char_in)) {
+			continue;
+		}
+		
+#ifdef DEBUG_HK
+		if (char_in == '!') {
+			log_put_string("! hotkey entered - printing processes on ready queue\n\r");
+			print(ready_pq);
+		}
+		else if (char_in == '@') {
+			log_put_string("@ hotkey entered - printing processes on blocked on memory queue\n\r");
+			print(blocked_memory_pq);
+		}
+		else if (char_in == '#') {
+			log_put_string("# hotkey entered - printing processes on blocked on receive queue\n\r");
+			print(blocked_waiting_pq);
+		}
+#endif // DEBUG_HK
+		
+		uart_line_discipline(pUart, char_in);
+	}
+}
+
 // UART initialized in uart_irq.c
 void UART_IPROC(void)
 {
-	MSG_BUF* received_message;
-	MSG_BUF* message_to_send;
 	LPC_UART_TypeDef* pUart = (LPC_UART_TypeDef*) LPC_UART0;
 	U8 IIR_IntId;	    // Interrupt ID from IIR
+	U8 iir;
 	
 	// Save the previously running proccess and set the current process to this i-proc
 	PCB* old_proc = gp_current_process;
@@ -444,75 +485,30 @@ void UART_IPROC(void)
 	g_switch_flag = 0;  // Reset the switch flag
 	
 #ifdef DEBUG_0
-	uart1_put_string("Entering UART i-proc\n\r");
+	LOG0(LOG_UART_ENTER);
 #endif // DEBUG_0
 	
-	/* Reading IIR automatically acknowledges the interrupt */
-	IIR_IntId = (pUart->IIR) >> 1 ; // skip pending bit in IIR
-	
-	if (IIR_IntId & IIR_RDA) { // Receive Data Available
-		/* read UART. Read RBR will clear the interrupt */
-		g_char_in = pUart->RBR;
+	/* Handle every interrupt the UART has pending. Reading IIR acknowledges THRE */
+	while (!((iir = pUart->IIR) & IIR_PEND)) {
+		IIR_IntId = (iir >> 1) & IIR_ID_MASK; // skip pending bit in IIR
+		TRACE(TRACE_UART_IRQ, PID_UART_IPROC, IIR_IntId);
 		
+		switch (IIR_IntId) {
+			case IIR_RLS: // Receive Line Status, cleared by reading LSR while draining
+			case IIR_RDA: // Receive Data Available, the FIFO reached its trigger level
+			case IIR_CTI: // Character Timeout, fewer chars than the trigger level are waiting
+				uart_rx_drain(pUart);
+				break;
+			case IIR_THRE: // The TX FIFO is empty
+				uart_tx_load_messages();
+				uart_tx_fill(pUart);
+				break;
+			default: /* not implemented yet */
 #ifdef DEBUG_0
-		uart1_put_string("Reading a char = ");
-		uart1_put_char(g_char_in);
-		uart1_put_string("\r\n");
+				LOG1(LOG_UART_UNKNOWN, IIR_IntId);
 #endif // DEBUG_0
-		
-#ifdef DEBUG_HK
-		if (g_char_in == '!') {
-			uart1_put_string("! hotkey entered - printing processes on ready queue\n\r");
-			print(ready_pq);
-		}
-		else if (g_char_in == '@') {
-			uart1_put_string("@ hotkey entered - printing processes on blocked on memory queue\n\r");
-			print(blocked_memory_pq);
-		}
-		else if (g_char_in == '#') {
-			uart1_put_string("# hotkey entered - printing processes on blocked on receive queue\n\r");
-			print(blocked_waiting_pq);
-		}
-#endif // DEBUG_HK
-		
-		// send char to KCD, which will handle parsing and send each character to CRT for printing
-		message_to_send = (MSG_BUF*)ki_request_memory_block();
-		if (message_to_send) {
-			message_to_send->mtype = USER_INPUT;
-			message_to_send->mtext[0] = g_char_in;
-			message_to_send->mtext[1] = '\0';
-			k_send_message(PID_KCD, message_to_send);
+				break;
 		}
-		else {
-			uart0_put_char(g_char_in);
-			if (g_char_in == '\r') {
-				uart0_put_char('\n');
-				uart0_put_string("ERROR: System out of memory!\r\n");
-			}
-		}
-	}
-	else if (IIR_IntId & IIR_THRE) {
-		/* THRE Interrupt, transmit holding register becomes empty */
-		received_message = (MSG_BUF*)ki_receive_message((int*)0);
-		gp_buffer = received_message->mtext;
-		
-		pUart->IER ^= IER_THRE; // toggle the IER_THRE bit
-		//pUart->THR = '\0';
-		
-		while (*gp_buffer != '\0' ) {
-			g_char_out = *gp_buffer;
-			pUart->THR = g_char_out;
-			gp_buffer++;
-			uart1_put_string(".");
-		}
-		uart1_put_string("\r\n");
-		gp_buffer = g_buffer;
-		k_release_memory_block((void*)received_message);
-	}
-	else {  /* not implemented yet */
-#ifdef DEBUG_0
-		uart1_put_string("Should not get here!\n\r");
-#endif // DEBUG_0
 	}
 	
 	//Restore the current process
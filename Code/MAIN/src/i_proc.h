@@ -8,8 +8,12 @@
  
 #include <stdint.h>
 
+#define TIMER_PRESCALE_US 24	/* PCLK = 25 MHZ, so TC counts every 25 PCLKs = 1 us */
+#define TIMER_US_PER_TICK 1000	/* the timer i-process runs every 1 ms */
+
 extern uint32_t timer_init (uint8_t n_timer);  /* initialize timer n_timer */
 extern uint32_t get_current_time(void);
+extern uint64_t get_monotonic_time_us(void);  /* call with interrupts disabled */
 extern uint32_t get_current_bench_time(void);
 extern void timer_i_process(void);
 extern void UART0_IRQHandler(void);
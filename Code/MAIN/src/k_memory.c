@@ -4,10 +4,8 @@
  */
 
 #include "k_memory.h"
-
-#ifdef DEBUG_0
-#include "printf.h"
-#endif /* ! DEBUG_0 */
+#include "k_timer.h"
+#include "trace.h"
 
 extern int k_release_processor(void);
 
@@ -16,10 +14,14 @@ U32 *gp_stack; /* The last allocated stack low address. 8 bytes aligned */
                /* The first stack starts at the RAM high address */
 	       /* stack grows down. Fully decremental stack */
 ForwardList* heap; // Pointer to the heap
+U8* heap_start; // Address of the first memory block
+U8* heap_end;   // Address just past the last memory block
+ForwardList* bulk_buffers; // List of free bulk buffers
+U8* bulk_buffers_start; // Address of the first bulk buffer
+U8* bulk_buffers_end;   // Address just past the last bulk buffer
 PriorityQueue* ready_pq; // Ready queue to hold the PCBs
 PriorityQueue* blocked_memory_pq; // Blocked priority queue to hold PCBs blocked due to memory
 PriorityQueue* blocked_waiting_pq; // Blocked priority queue to hold PCBs blocked due to waiting for a message
-extern ForwardList* delayed_messages; // List of delayed messages
 
 /**
  * @brief: Initialize RAM as follows:
@@ -33,6 +35,10 @@ extern ForwardList* delayed_messages; // List of delayed messages
           |        HEAP               |
           |                           |
           |---------------------------|<--- p_end (before heap alloc)
+          |        BULK BUFFERS       |
+          |---------------------------|
+          |   Queues and lists        |
+          |---------------------------|
           |        PCB 2              |
           |---------------------------|
           |        PCB 1              |
@@ -89,10 +95,19 @@ void memory_init(void)
 	p_end += sizeof(PriorityQueue);
 	init_pq(blocked_waiting_pq);
 
-	// Allocate memory for the list of delayed messages
-	delayed_messages = (ForwardList*)p_end; 
+	// Carve out the bulk buffers that messages can hand off without copying
+	bulk_buffers = (ForwardList*)p_end;
 	p_end += sizeof(ForwardList);
-	init(delayed_messages);
+	init(bulk_buffers);
+	
+	bulk_buffers_start = p_end;
+	for (i = 0; i < NUM_BULK_BUFFERS; i++) {
+		((BULK_BUFFER*)p_end)->owner_pid = PID_NULL;
+		((BULK_BUFFER*)p_end)->attached = 0;
+		push_front(bulk_buffers, (ListNode*)p_end);
+		p_end += sizeof(BULK_BUFFER) + SZ_BULK_BUFFER;
+	}
+	bulk_buffers_end = p_end;
   
 	/* allocate memory for the heap */
 	
@@ -100,6 +115,7 @@ void memory_init(void)
 	heap = (ForwardList *)p_end; 
 	p_end += sizeof(ForwardList);
 	init(heap);
+	heap_start = p_end;
 	
 	// Build the heap
 	#ifdef DEBUG_CUSTOM_HEAP
@@ -116,7 +132,7 @@ void memory_init(void)
 		push_front(heap, (ListNode *)heap_block);
 		p_end += USR_SZ_MEM_BLOCK;
 	}
-	
+	heap_end = p_end;
 }
 
 /**
@@ -141,24 +157,53 @@ U32 *alloc_stack(U32 size_b)
 	return sp;
 }
 
+/**
+ * @brief: Checks that p_mem_blk is the content of a memory block, as returned by k_request_memory_block
+ * @return: 1 if it is, 0 otherwise
+ */
+int is_heap_block(void* p_mem_blk)
+{
+	U8* block = (U8*)p_mem_blk - SZ_MEM_BLOCK_HEADER;
+	
+	return p_mem_blk != NULL && block >= heap_start && block < heap_end
+	        && (block - heap_start) % USR_SZ_MEM_BLOCK == 0;
+}
+
+/**
+ * @brief: Pops a memory block off the heap and gives its message header default values
+ * @return: A pointer to the content of the memory block
+ * PRE: IRQs are disabled and the heap is not empty
+ */
+void *take_heap_block(void)
+{
+	MSG_ENVELOPE* envelope = (MSG_ENVELOPE*)pop_front(heap);
+	envelope->priority = MSG_PRIORITY_DEFAULT;
+	envelope->flags = 0;
+	return (void*)((U8*)envelope + SZ_MEM_BLOCK_HEADER);
+}
+
 void *k_request_memory_block(void)
 {
+	void* p_mem_blk;
+	
 	__disable_irq(); // atomic(on)
 
 	//While there are no memory blocks left on the heap, block the current process
 	while (empty(heap)) {
-	#ifdef DEBUG_0 
-		printf("Process %d blocked \r\n", gp_current_process->m_pid);
-	#endif
+		TRACE(TRACE_MEM_BLOCKED, gp_current_process->m_pid, 0);
 		gp_current_process->m_state = BLOCKED;
 		push(blocked_memory_pq, (QNode *) gp_current_process, gp_current_process->m_priority);
 		k_release_processor();
+		__disable_irq(); // k_release_processor turned irq back on
 	}
 	
+	//Pop a memory block off the heap
+	p_mem_blk = take_heap_block();
+	
 	__enable_irq(); // atomic(off)
 	
-	//Pop a memory block off the heap and return a pointer to its content
-	return (void*)((U8*)pop_front(heap) + SZ_MEM_BLOCK_HEADER);
+	//Return a pointer to its content
+	return p_mem_blk;
 }
 
 /**
@@ -171,30 +216,48 @@ void* ki_request_memory_block(void)
 		return (void*)0;
 	}
 	// Pop a memory block off the heap and return a pointer to its content
-	return (void*)((U8*)pop_front(heap) + SZ_MEM_BLOCK_HEADER);
+	return take_heap_block();
 }
 
 int k_release_memory_block(void *p_mem_blk)
 {
+	MSG_ENVELOPE* envelope;
+	
 	__disable_irq(); // atomic(on)
 
 	//Return an error if the input memory block is not valid
-	if (p_mem_blk == NULL) {
+	if (!is_heap_block(p_mem_blk)) {
 		__enable_irq();
 		return RTX_ERR;
 	}
 
+	// The notification of a periodic timer goes back to its timer to be delivered again
+	envelope = (MSG_ENVELOPE*)((U8*)p_mem_blk - SZ_MEM_BLOCK_HEADER);
+	if ((envelope->flags & MSG_FLAG_TIMER) && reclaim_timer_notification(envelope)) {
+		if (!gp_current_process->m_is_iproc) {
+			__enable_irq();
+		}
+		return RTX_OK;
+	}
+	
+	// A message that owns a bulk buffer gives it back along with itself
+	if (envelope->flags & MSG_FLAG_BULK) {
+		BULK_BUFFER* buffer = bulk_buffer_at(envelope->bulk_id);
+		buffer->owner_pid = PID_NULL;
+		buffer->attached = 0;
+		push_front(bulk_buffers, (ListNode*)buffer);
+		envelope->flags = 0;
+	}
+
 	// Put the memory block back onto the heap
-	push_front(heap, (ListNode*)((U8*)p_mem_blk - SZ_MEM_BLOCK_HEADER));
+	push_front(heap, (ListNode*)envelope);
 
 	// If the blocked queue is not empty, take the first process and put it on the ready queue
 	// (since now there is memory available for that process to continue)
 	if (!pq_empty(blocked_memory_pq)) {
 		PCB* proc_to_unblock = (PCB*)pop(blocked_memory_pq);
 		proc_to_unblock->m_state = READY;
-	#ifdef DEBUG_0 
-		printf("Unblocking process ID %x\r\n", proc_to_unblock->m_pid);
-	#endif
+		TRACE(TRACE_MEM_UNBLOCKED, gp_current_process->m_pid, proc_to_unblock->m_pid);
 		push(ready_pq, (QNode*)proc_to_unblock, proc_to_unblock->m_priority);
 		// Only preempt if the current process is not an i-process
 		if (!gp_current_process->m_is_iproc) {
@@ -209,3 +272,131 @@ int k_release_memory_block(void *p_mem_blk)
 	
 	return RTX_OK;
 }
+
+/**
+ * @brief: Gets the header of a bulk buffer from a pointer to its data
+ * @return: A pointer to the bulk buffer header, or NULL if p_buf is not the start of a bulk buffer's data
+ */
+BULK_BUFFER* get_bulk_buffer(void* p_buf)
+{
+	U8* header = (U8*)p_buf - sizeof(BULK_BUFFER);
+	
+	if (p_buf == NULL || header < bulk_buffers_start || header >= bulk_buffers_end
+	        || (header - bulk_buffers_start) % (sizeof(BULK_BUFFER) + SZ_BULK_BUFFER) != 0) {
+		return NULL;
+	}
+	return (BULK_BUFFER*)header;
+}
+
+/**
+ * @brief: Gets the header of the bulk buffer with the given index, as stored in an envelope's bulk_id
+ * PRE: 0 <= index < NUM_BULK_BUFFERS
+ */
+BULK_BUFFER* bulk_buffer_at(int index)
+{
+	return (BULK_BUFFER*)(bulk_buffers_start + index * (sizeof(BULK_BUFFER) + SZ_BULK_BUFFER));
+}
+
+/**
+ * @brief: Takes a bulk buffer out of the pool for the current process.
+ *         Bulk buffers are a small fixed pool, so this does not block.
+ * @return: A pointer to the SZ_BULK_BUFFER bytes of the buffer, or NULL if every bulk buffer is in use
+ */
+void *k_request_bulk_buffer(void)
+{
+	BULK_BUFFER* buffer;
+	
+	__disable_irq(); // atomic(on)
+	
+	buffer = (BULK_BUFFER*)pop_front(bulk_buffers);
+	if (buffer == NULL) {
+		__enable_irq();
+		return NULL;
+	}
+	buffer->owner_pid = gp_current_process->m_pid;
+	
+	__enable_irq(); // atomic(off)
+	
+	return (U8*)buffer + sizeof(BULK_BUFFER);
+}
+
+/**
+ * @brief: Returns a bulk buffer owned by the current process to the pool.
+ *         Buffers attached to a message are returned by releasing the message instead.
+ * @return: RTX_OK upon success
+ *          RTX_ERR upon failure (including when the buffer is attached to a message)
+ */
+int k_release_bulk_buffer(void *p_buf)
+{
+	BULK_BUFFER* buffer;
+	
+	__disable_irq(); // atomic(on)
+	
+	buffer = get_bulk_buffer(p_buf);
+	if (buffer == NULL || buffer->owner_pid != gp_current_process->m_pid || buffer->attached) {
+		__enable_irq();
+		return RTX_ERR;
+	}
+	buffer->owner_pid = PID_NULL;
+	push_front(bulk_buffers, (ListNode*)buffer);
+	
+	__enable_irq(); // atomic(off)
+	
+	return RTX_OK;
+}
+
+/**
+ * @brief: Hands a bulk buffer owned by the current process over to a message.
+ *         The message's mtext holds a BULK_DESC for the receiver to find the buffer, ownership of the buffer moves
+ *         to whichever process the message is sent to, and the buffer is returned to the pool
+ *         when that process releases the message. Until then the buffer can't be released or
+ *         attached to another message.
+ * @param: length, the number of bytes of the buffer in use
+ * @return: RTX_OK upon success
+ *          RTX_ERR upon failure
+ */
+int k_attach_bulk_buffer(void *p_msg, void *p_buf, int length)
+{
+	BULK_BUFFER* buffer;
+	MSG_ENVELOPE* envelope;
+	BULK_DESC* desc;
+	
+	__disable_irq(); // atomic(on)
+	
+	buffer = get_bulk_buffer(p_buf);
+	if (p_msg == NULL || buffer == NULL || buffer->owner_pid != gp_current_process->m_pid
+	        || buffer->attached || length < 0 || length > SZ_BULK_BUFFER) {
+		__enable_irq();
+		return RTX_ERR;
+	}
+	
+	// A message can only carry one bulk buffer
+	envelope = (MSG_ENVELOPE*)((U8*)p_msg - SZ_MEM_BLOCK_HEADER);
+	if (envelope->flags & MSG_FLAG_BULK) {
+		__enable_irq();
+		return RTX_ERR;
+	}
+	
+	// The kernel keeps track of the buffer in the envelope, where the process can't change it
+	desc = (BULK_DESC*)((MSG_BUF*)p_msg)->mtext;
+	desc->data = p_buf;
+	desc->length = length;
+	envelope->bulk_id = ((U8*)buffer - bulk_buffers_start) / (sizeof(BULK_BUFFER) + SZ_BULK_BUFFER);
+	envelope->flags |= MSG_FLAG_BULK;
+	buffer->attached = 1;
+	
+	__enable_irq(); // atomic(off)
+	
+	return RTX_OK;
+}
+
+/**
+ * @brief: Moves ownership of the bulk buffer attached to the envelope (if any) to the process with the given pid
+ * PRE: IRQs are disabled
+ */
+void transfer_bulk_buffer(MSG_ENVELOPE* envelope, int pid)
+{
+	if (envelope->flags & MSG_FLAG_BULK) {
+		bulk_buffer_at(envelope->bulk_id)->owner_pid = pid;
+	}
+}
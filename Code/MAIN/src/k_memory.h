@@ -25,5 +25,11 @@ void memory_init(void);
 U32 *alloc_stack(U32 size_b);
 void *k_request_memory_block(void);
 int k_release_memory_block(void *);
+int is_heap_block(void* p_mem_blk);
+void *k_request_bulk_buffer(void);
+int k_release_bulk_buffer(void *p_buf);
+int k_attach_bulk_buffer(void *p_msg, void *p_buf, int length);
+BULK_BUFFER* bulk_buffer_at(int index);
+void transfer_bulk_buffer(MSG_ENVELOPE* envelope, int pid);
 
 #endif /* ! K_MEM_H_ */
@@ -0,0 +1,177 @@
+/**
+ * @file:   k_pipe.c
+ * @brief:  Kernel pipes. A pipe moves bytes between processes through a ring buffer,
+ *          so character traffic doesn't need a memory block and a message per byte.
+ */
+
+#include <LPC17xx.h>
+#include "k_pipe.h"
+#include "k_process.h"
+
+extern PCB* gp_current_process;
+
+/* ----- Global Variables ----- */
+PIPE g_pipes[NUM_PIPES]; // Pool of pipes
+
+/**
+ * @brief: Initializes every pipe as empty and unused
+ */
+void pipe_init(void)
+{
+	int i;
+	for (i = 0; i < NUM_PIPES; i++) {
+		g_pipes[i].m_in_use = 0;
+		init_rb(&g_pipes[i].m_buffer, g_pipes[i].m_data, SZ_PIPE);
+		init_pq(&g_pipes[i].m_readers);
+		init_pq(&g_pipes[i].m_writers);
+	}
+}
+
+/**
+ * @brief: Gets the pipe with the given ID
+ * @return: A pointer to the pipe, or NULL if the ID is not a created pipe
+ */
+PIPE* get_pipe(int pipe_id)
+{
+	if (pipe_id < 0 || pipe_id >= NUM_PIPES || !g_pipes[pipe_id].m_in_use) {
+		return NULL;
+	}
+	return &g_pipes[pipe_id];
+}
+
+/**
+ * @brief: Makes every process in the queue READY. They check the pipe again when they run.
+ * @return: 1 if any process was woken, 0 otherwise
+ * PRE: IRQs are disabled
+ */
+int wake_pipe_waiters(PriorityQueue* waiters)
+{
+	PCB* pcb = (PCB*)pop_all(waiters);
+	PCB* next;
+	
+	if (pcb == NULL) {
+		return 0;
+	}
+	
+	while (pcb != NULL) {
+		next = pcb->mp_next;
+		make_ready(pcb);
+		pcb = next;
+	}
+	
+	return 1;
+}
+
+/**
+ * @brief: Blocks the current process in the queue until it is woken by the other end of the pipe
+ * PRE: IRQs are disabled
+ */
+void wait_on_pipe(PriorityQueue* waiters)
+{
+	gp_current_process->m_state = BLOCKED_ON_PIPE;
+	gp_current_process->mp_blocked_pq = waiters;
+	push(waiters, (QNode*)gp_current_process, gp_current_process->m_priority);
+	k_release_processor();
+	__disable_irq(); // k_release_processor turned irq back on
+}
+
+/**
+ * @brief: Creates an empty pipe
+ * @return: The ID of the new pipe, or RTX_ERR if there are no pipes left
+ */
+int k_create_pipe(void)
+{
+	int i;
+	
+	__disable_irq(); // atomic(on)
+	
+	for (i = 0; i < NUM_PIPES; i++) {
+		if (!g_pipes[i].m_in_use) {
+			g_pipes[i].m_in_use = 1;
+			init_rb(&g_pipes[i].m_buffer, g_pipes[i].m_data, SZ_PIPE);
+			__enable_irq(); // atomic(off)
+			return i;
+		}
+	}
+	
+	__enable_irq(); // atomic(off)
+	return RTX_ERR;
+}
+
+/**
+ * NOTE: BLOCKING write in PIPE_BLOCKING mode
+ * @brief: Writes len bytes from buf to the pipe. In PIPE_BLOCKING mode, waits for readers to make
+ *         room until every byte has been written. In PIPE_NONBLOCKING mode, writes what fits.
+ * @return: The number of bytes written, or RTX_ERR upon failure
+ */
+int k_pipe_write(int pipe_id, const char* buf, int len, int mode)
+{
+	PIPE* pipe;
+	int written = 0;
+	int woke = 0;
+	
+	__disable_irq(); // atomic(on)
+	
+	pipe = get_pipe(pipe_id);
+	if (pipe == NULL || buf == NULL || len < 0 || gp_current_process->m_is_iproc
+	        || (mode != PIPE_BLOCKING && mode != PIPE_NONBLOCKING)) {
+		__enable_irq();
+		return RTX_ERR;
+	}
+	
+	while (1) {
+		written += rb_write(&pipe->m_buffer, buf + written, len - written);
+		if (wake_pipe_waiters(&pipe->m_readers)) {
+			woke = 1;
+		}
+		if (written == len || mode == PIPE_NONBLOCKING) {
+			break;
+		}
+		wait_on_pipe(&pipe->m_writers);
+	}
+	
+	// Let any reader that was just woken preempt this process
+	if (woke) {
+		k_release_processor();
+	}
+	
+	__enable_irq(); // atomic(off)
+	
+	return written;
+}
+
+/**
+ * NOTE: BLOCKING read in PIPE_BLOCKING mode
+ * @brief: Reads up to len bytes from the pipe into buf. In PIPE_BLOCKING mode, waits until there
+ *         is at least one byte to read. In PIPE_NONBLOCKING mode, returns 0 if the pipe is empty.
+ * @return: The number of bytes read, or RTX_ERR upon failure
+ */
+int k_pipe_read(int pipe_id, char* buf, int len, int mode)
+{
+	PIPE* pipe;
+	int read;
+	
+	__disable_irq(); // atomic(on)
+	
+	pipe = get_pipe(pipe_id);
+	if (pipe == NULL || buf == NULL || len < 0 || gp_current_process->m_is_iproc
+	        || (mode != PIPE_BLOCKING && mode != PIPE_NONBLOCKING)) {
+		__enable_irq();
+		return RTX_ERR;
+	}
+	
+	while (mode == PIPE_BLOCKING && len > 0 && rb_empty(&pipe->m_buffer)) {
+		wait_on_pipe(&pipe->m_readers);
+	}
+	
+	read = rb_read(&pipe->m_buffer, buf, len);
+	
+	// Let any writer that was waiting for room preempt this process
+	if (read > 0 && wake_pipe_waiters(&pipe->m_writers)) {
+		k_release_processor();
+	}
+	
+	__enable_irq(); // atomic(off)
+	
+	return read;
+}
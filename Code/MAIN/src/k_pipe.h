@@ -0,0 +1,32 @@
+/**
+ * @file:   k_pipe.h
+ * @brief:  Kernel pipe header file
+ */
+
+#ifndef K_PIPE_H_
+#define K_PIPE_H_
+
+#include "k_rtx.h"
+#include "ring_buffer.h"
+
+/* ----- Types ----- */
+
+/* byte stream between processes */
+typedef struct pipe
+{
+	int m_in_use;				/* whether or not the pipe has been created */
+	RingBuffer m_buffer;		/* bytes written and not yet read */
+	char m_data[SZ_PIPE];		/* storage for m_buffer */
+	PriorityQueue m_readers;	/* processes blocked reading from the empty pipe */
+	PriorityQueue m_writers;	/* processes blocked writing to the full pipe */
+} PIPE;
+
+/* ----- Functions ----- */
+
+void pipe_init(void);						/* initialize every pipe as unused */
+
+int k_create_pipe(void);
+int k_pipe_write(int pipe_id, const char* buf, int len, int mode);
+int k_pipe_read(int pipe_id, char* buf, int len, int mode);
+
+#endif /* ! K_PIPE_H_ */
@@ -0,0 +1,171 @@
+/**
+ * @file:   k_port.c
+ * @brief:  Kernel name service. Processes bind names to ports, and senders look a name up once
+ *          to get a port ID that they can send to in constant time from then on. Port IDs stay
+ *          valid when another process binds the same name, so a service can be replaced without
+ *          its clients noticing.
+ */
+
+#include <LPC17xx.h>
+#include "k_port.h"
+#include "k_process.h"
+
+extern PCB* gp_current_process;
+
+/* ----- Global Variables ----- */
+PORT g_ports[NUM_PORTS]; // Table of named ports, indexed by port ID
+
+/**
+ * @brief: Gets the port with the given ID
+ * @return: A pointer to the port, or NULL if the ID is not a bound port
+ */
+PORT* get_port(int port_id)
+{
+	if (port_id < 0 || port_id >= NUM_PORTS || g_ports[port_id].mp_owner == NULL) {
+		return NULL;
+	}
+	return &g_ports[port_id];
+}
+
+/**
+ * @brief: Finds the port with the given name
+ * @return: The ID of the port, or RTX_ERR if no port has been bound with the name
+ */
+int find_port(const char* name)
+{
+	int i;
+	int j;
+	
+	for (i = 0; i < NUM_PORTS; i++) {
+		if (g_ports[i].mp_owner == NULL) {
+			continue;
+		}
+		for (j = 0; g_ports[i].m_name[j] == name[j]; j++) {
+			if (name[j] == '\0') {
+				return i;
+			}
+		}
+	}
+	
+	return RTX_ERR;
+}
+
+/**
+ * @brief: Binds the name to a port owned by the given process, taking the port over if the name is already bound
+ * @return: The ID of the port, or RTX_ERR if the name is empty or too long, or there are no ports left
+ * PRE: IRQs are disabled
+ */
+int assign_port(const char* name, PCB* owner)
+{
+	int port_id;
+	int i;
+	
+	if (name == NULL || name[0] == '\0') {
+		return RTX_ERR;
+	}
+	
+	port_id = find_port(name);
+	if (port_id == RTX_ERR) {
+		for (i = 0; i < SZ_PORT_NAME && name[i] != '\0'; i++);
+		if (i == SZ_PORT_NAME) { // No room for the null terminator
+			return RTX_ERR;
+		}
+		
+		for (port_id = 0; port_id < NUM_PORTS && g_ports[port_id].mp_owner != NULL; port_id++);
+		if (port_id == NUM_PORTS) {
+			return RTX_ERR;
+		}
+		
+		for (i = 0; name[i] != '\0'; i++) {
+			g_ports[port_id].m_name[i] = name[i];
+		}
+		g_ports[port_id].m_name[i] = '\0';
+	}
+	
+	g_ports[port_id].mp_owner = owner;
+	
+	return port_id;
+}
+
+/**
+ * @brief: Marks every port as unused, then binds the ports of the system processes
+ */
+void port_init(void)
+{
+	int i;
+	for (i = 0; i < NUM_PORTS; i++) {
+		g_ports[i].m_name[0] = '\0';
+		g_ports[i].mp_owner = NULL;
+	}
+	
+	// Bound before any process runs so that clients can look them up as soon as they start
+	assign_port("KCD", get_proc_by_pid(PID_KCD));
+	assign_port("CRT", get_proc_by_pid(PID_CRT));
+}
+
+/**
+ * @brief: Binds the name to a port that delivers messages to the current process.
+ *         If the name is already bound, the current process takes the port over.
+ * @return: The ID of the port, or RTX_ERR upon failure
+ */
+int k_bind_port(const char* name)
+{
+	int port_id;
+	
+	__disable_irq(); // atomic(on)
+	
+	if (gp_current_process->m_is_iproc) {
+		return RTX_ERR;
+	}
+	
+	port_id = assign_port(name, gp_current_process);
+	
+	__enable_irq(); // atomic(off)
+	
+	return port_id;
+}
+
+/**
+ * @brief: Looks up the port bound with the given name
+ * NOTE: Can be called from i-processes.
+ * @return: The ID of the port, or RTX_ERR if no port has been bound with the name
+ */
+int k_lookup_port(const char* name)
+{
+	int port_id;
+	
+	__disable_irq(); // atomic(on)
+	
+	port_id = name == NULL ? RTX_ERR : find_port(name);
+	
+	// Only re-enable irq if the current process is not an i-process
+	if (!gp_current_process->m_is_iproc) {
+		__enable_irq(); // atomic(off)
+	}
+	
+	return port_id;
+}
+
+/**
+ * @brief: Sends a message to the process that owns the port
+ * NOTE: Can be called from i-processes.
+ * @return: RTX_OK upon success
+ *          RTX_ERR upon failure
+ */
+int k_send_to_port(int port_id, void* p_msg)
+{
+	PORT* port;
+	
+	__disable_irq(); // atomic(on)
+	
+	port = get_port(port_id);
+	if (port == NULL) {
+		if (!gp_current_process->m_is_iproc) {
+			__enable_irq();
+		}
+		return RTX_ERR;
+	}
+	
+	// k_send_message does the rest of the work in the same critical section
+	return k_send_message(port->mp_owner->m_pid, p_msg);
+}
@@ -0,0 +1,28 @@
+/**
+ * @file:   k_port.h
+ * @brief:  Kernel name service header file
+ */
+
+#ifndef K_PORT_H_
+#define K_PORT_H_
+
+#include "k_rtx.h"
+
+/* ----- Types ----- */
+
+/* named port that messages can be sent to without knowing the PID of the receiver */
+typedef struct port
+{
+	char m_name[SZ_PORT_NAME];	/* null-terminated name the port is looked up by, empty if unused */
+	PCB* mp_owner;				/* process that receives the messages sent to the port */
+} PORT;
+
+/* ----- Functions ----- */
+
+void port_init(void);						/* initialize the port table and bind the system ports */
+
+int k_bind_port(const char* name);
+int k_lookup_port(const char* name);
+int k_send_to_port(int port_id, void* p_msg);
+
+#endif /* ! K_PORT_H_ */
@@ -9,10 +9,13 @@
 #include <LPC17xx.h>
 #include <system_LPC17xx.h>
 #include "k_process.h"
+#include "k_sync.h"
 #include "uart_polling.h"
 #include "i_proc.h"
+#include "uart_tx.h"
 #include "sys_proc.h"
 #include "usr_proc.h"
+#include "trace.h"
 
 #ifdef DEBUG_0
 #include "printf.h"
@@ -33,6 +36,9 @@ extern PROC_INIT g_test_procs[NUM_TEST_PROCS];
 // So the timer has a reference to its pcb
 extern PCB* timer_proc;
 
+extern void transfer_bulk_buffer(MSG_ENVELOPE* envelope, int pid);
+extern int is_heap_block(void* p_mem_blk);
+
 
 /* The null process */
 void nullproc(void)
@@ -132,10 +138,25 @@ void process_init()
 
 		gp_pcbs[i]->m_pid = g_proc_table[i].m_pid;
 		gp_pcbs[i]->m_priority = g_proc_table[i].m_priority;
+		gp_pcbs[i]->m_base_priority = g_proc_table[i].m_priority;
 		// If the PID of the process is less than that of the first i-proc, it is not an i-proc
 		gp_pcbs[i]->m_is_iproc = g_proc_table[i].m_pid < PID_TIMER_IPROC ? 0 : 1;
 		gp_pcbs[i]->m_state = NEW;
-		init_q(&gp_pcbs[i]->m_message_q);
+		init_pq(&gp_pcbs[i]->m_message_q);
+		gp_pcbs[i]->m_message_count = 0;
+		gp_pcbs[i]->m_mailbox_limit = 0; // Mailboxes are unbounded until a limit is set
+		gp_pcbs[i]->m_mailbox_mode = MAILBOX_BLOCKING;
+		init_pq(&gp_pcbs[i]->m_send_waiters);
+		gp_pcbs[i]->mp_blocked_pq = NULL;
+		gp_pcbs[i]->m_event_flags = 0;
+		gp_pcbs[i]->m_event_wait_mask = 0;
+		gp_pcbs[i]->mp_held_mutexes = NULL;
+		gp_pcbs[i]->mp_blocked_mutex = NULL;
+		gp_pcbs[i]->m_sleep_timer.m_state = TIMER_FREE;
+		gp_pcbs[i]->m_sleep_timer.m_period = 0;
+		gp_pcbs[i]->m_sleep_timer.m_slack = 0;
+		gp_pcbs[i]->m_sleep_timer.mp_envelope = NULL;
+		gp_pcbs[i]->m_sleep_timer.mp_sleeper = gp_pcbs[i];
 		
 		sp = alloc_stack(g_proc_table[i].m_stack_size);
 		*(--sp)  = INITIAL_xPSR;      // user process initial xPSR  
@@ -160,6 +181,27 @@ void process_init()
 	timer_proc = gp_pcbs[NUM_PROCS - 3]; // So the timer has a reference to its pcb
 }
 
+/**
+ * @brief: Determines whether or not the process is waiting in one of the blocked states
+ * @return: 1 if the process is blocked, 0 otherwise
+ */
+int is_blocked(PCB* pcb)
+{
+	switch (pcb->m_state) {
+		case BLOCKED:
+		case BLOCKED_ON_RECEIVE:
+		case BLOCKED_ON_SEND:
+		case BLOCKED_ON_EVENT:
+		case BLOCKED_ON_SEMAPHORE:
+		case BLOCKED_ON_MUTEX:
+		case BLOCKED_ON_PIPE:
+		case SLEEPING:
+			return 1;
+		default:
+			return 0;
+	}
+}
+
 /**
  * @brief: scheduler, picks the next to run process
  * @return: PCB pointer of the next to run process
@@ -171,7 +213,7 @@ PCB* scheduler(void)
 	PCB* next_pcb;
 	PCB* top_pcb = (PCB*)top(ready_pq);
 	
-  if (gp_current_process == NULL || (top_pcb != NULL && top_pcb->m_priority <= gp_current_process->m_priority) || gp_current_process->m_state == BLOCKED || gp_current_process->m_state == BLOCKED_ON_RECEIVE) {
+  if (gp_current_process == NULL || (top_pcb != NULL && top_pcb->m_priority <= gp_current_process->m_priority) || is_blocked(gp_current_process)) {
 		next_pcb = (PCB*)pop(ready_pq);
 	}
 	else {
@@ -219,6 +261,7 @@ int process_switch(PCB* p_pcb_old)
 			p_pcb_old->mp_sp = (U32*)__get_MSP(); //Save the old process's sp
 			configure_old_pcb(p_pcb_old); //Configure the old PCB
 		}
+		TRACE(TRACE_SWITCH, p_pcb_old->m_pid, gp_current_process->m_pid);
 		gp_current_process->m_state = RUNNING;
 		__enable_irq();
 		__set_MSP((U32) gp_current_process->mp_sp);
@@ -240,6 +283,7 @@ int process_switch(PCB* p_pcb_old)
 		configure_old_pcb(p_pcb_old); //Configure the old PCB
 		
 		//Run the new current process
+		TRACE(TRACE_SWITCH, p_pcb_old->m_pid, gp_current_process->m_pid);
 		gp_current_process->m_state = RUNNING;
 		__enable_irq();
 		__set_MSP((U32) gp_current_process->mp_sp); //Switch to the new proc's stack
@@ -306,6 +350,55 @@ int k_get_process_priority(int pid)
 	return pcb->m_priority;
 }
 
+/**
+ * @brief: Changes the priority the scheduler uses for the process, moving the process
+ *         to its new location in whichever priority queue it is waiting in
+ * @return: 1 upon success, 0 if the process could not be found in its queue
+ * PRE: IRQs are disabled
+ */
+int change_priority(PCB* pcb, int priority)
+{
+	PriorityQueue* pqueue;
+	
+	switch (pcb->m_state) {
+		// If the process is in the blocked on memory queue
+		case BLOCKED:
+			pqueue = blocked_memory_pq;
+			break;
+		// If the process is in the blocked on receive queue
+		case BLOCKED_ON_RECEIVE:
+			pqueue = blocked_waiting_pq;
+			break;
+		// If the process is blocked sending to a full mailbox or waiting on a semaphore, mutex or pipe
+		case BLOCKED_ON_SEND:
+		case BLOCKED_ON_SEMAPHORE:
+		case BLOCKED_ON_MUTEX:
+		case BLOCKED_ON_PIPE:
+			pqueue = pcb->mp_blocked_pq;
+			break;
+		// If the process is in the ready queue
+		case NEW:
+		case READY:
+			pqueue = ready_pq;
+			break;
+		// If the process is running, waiting for event flags or sleeping (it isn't in any queue)
+		default:
+			pqueue = NULL;
+			break;
+	}
+	
+	//Move the process to its new location in the priority queue based on its new priority
+	if (pqueue != NULL) {
+		if (!remove_at_priority(pqueue, (QNode*)pcb, pcb->m_priority)) {
+			return 0;
+		}
+		push(pqueue, (QNode*)pcb, priority);
+	}
+	pcb->m_priority = priority;
+	
+	return 1;
+}
+
 int k_set_process_priority(int pid, int priority)
 {
 	PCB* pcb;
@@ -329,46 +422,23 @@ int k_set_process_priority(int pid, int priority)
 		return RTX_ERR;
 	}
 	
-	if (pcb->m_priority == priority) { //Nothing to change
+	if (pcb->m_base_priority == priority) { //Nothing to change
 		__enable_irq();
 		return RTX_OK;
 	}
 	
-	switch (pcb->m_state) {
-		// If the process is in the blocked on memory queue
-		case BLOCKED:
-			//Move the process to its new location in the priority queue based on its new priority
-			if (!remove_at_priority(blocked_memory_pq, (QNode*)pcb, pcb->m_priority)) {
-				__enable_irq();
-				return RTX_ERR;
-			}
-			push(blocked_memory_pq, (QNode*)pcb, priority);
-			pcb->m_priority = priority;
-			break;
-		// If the process is in the blocked on receive queue
-		case BLOCKED_ON_RECEIVE:
-			//Move the process to its new location in the priority queue based on its new priority
-			if (!remove_at_priority(blocked_waiting_pq, (QNode*)pcb, pcb->m_priority)) {
-				__enable_irq();
-				return RTX_ERR;
-			}
-			push(blocked_waiting_pq, (QNode*)pcb, priority);
-			pcb->m_priority = priority;
-			break;
-		// If the process is in the ready queue
-		case NEW:
-		case READY:
-			//Move the process to its new location in the priority queue based on its new priority
-			if (!remove_at_priority(ready_pq, (QNode*)pcb, pcb->m_priority)) {
-				__enable_irq();
-				return RTX_ERR;
-			}
-			push(ready_pq, (QNode*)pcb, priority);
-		default:
-			pcb->m_priority = priority;
-			k_release_processor();
-			__disable_irq();
-			break;
+	// The process keeps any higher priority it has inherited through the mutexes it holds,
+	// and passes its new priority on to the holder of any mutex it is waiting for
+	pcb->m_base_priority = priority;
+	if (!update_priority_chain(pcb)) {
+		__enable_irq();
+		return RTX_ERR;
+	}
+	
+	// Blocked processes can't run yet, so only preempt for a process that is ready or running
+	if (!is_blocked(pcb)) {
+		k_release_processor();
+		__disable_irq();
 	}
 	
 	__enable_irq();
@@ -386,6 +456,130 @@ void* k_envelope_to_message(MSG_ENVELOPE* envelope)
 	return (U8*)envelope + SZ_MEM_BLOCK_HEADER;
 }
 
+/**
+ * @brief: Adds the envelope to the receiving process's message queue and, if the receiving process
+ *         is blocked waiting for a message, moves it from the blocked queue to the ready queue
+ * @return: 1 if the receiving process was made READY (so the sender should give it a chance to run)
+ *          0 otherwise
+ * PRE: IRQs are disabled
+ */
+int deliver_message(PCB* receiving_proc, MSG_ENVELOPE* envelope)
+{
+	// Any bulk buffer the message carries now belongs to the receiving process
+	transfer_bulk_buffer(envelope, receiving_proc->m_pid);
+	
+	// enqueue message_envelope onto the message_q of receiving_proc behind messages of the same or higher priority
+	push(&receiving_proc->m_message_q, (QNode *)envelope, envelope->priority);
+	receiving_proc->m_message_count++;
+	
+	// The UART i-process copies its messages into the TX buffer as the TX FIFO empties, so make sure it will
+	if (receiving_proc->m_pid == PID_UART_IPROC) {
+		uart_tx_start();
+	}
+
+	if (receiving_proc->m_state != BLOCKED_ON_RECEIVE) {
+		return 0;
+	}
+	
+	if (!remove_at_priority(blocked_waiting_pq, (QNode*)receiving_proc, receiving_proc->m_priority)) {
+		return 0;
+	}
+	make_ready(receiving_proc);
+	
+	return 1;
+}
+
+/**
+ * @brief: Determines whether or not the process's mailbox has reached its limit
+ * @return: 1 if the mailbox is full, 0 otherwise
+ */
+int mailbox_full(PCB* receiving_proc)
+{
+	return receiving_proc->m_mailbox_limit > 0 && receiving_proc->m_message_count >= receiving_proc->m_mailbox_limit;
+}
+
+/**
+ * @brief: Blocks the current process until there is room in the receiving process's mailbox
+ * @return: RTX_OK once there is room in the mailbox
+ *          RTX_ERR if the mailbox is full and in non-blocking mode, or is the current process's own
+ *          (only the current process could make room in it, so it would block forever)
+ * PRE: IRQs are disabled and the current process is not an i-process
+ */
+int wait_for_mailbox_space(PCB* receiving_proc)
+{
+	while (mailbox_full(receiving_proc)) {
+		if (receiving_proc->m_mailbox_mode == MAILBOX_NONBLOCKING || receiving_proc == gp_current_process) {
+			return RTX_ERR;
+		}
+		gp_current_process->m_state = BLOCKED_ON_SEND;
+		gp_current_process->mp_blocked_pq = &receiving_proc->m_send_waiters;
+		push(&receiving_proc->m_send_waiters, (QNode*)gp_current_process, gp_current_process->m_priority);
+		k_release_processor();
+		__disable_irq(); // k_release_processor turned irq back on
+	}
+	return RTX_OK;
+}
+
+/**
+ * @brief: Moves every process blocked sending to the receiving process onto the ready queue so they
+ *         can retry their sends. All of them are woken since the first to run may not fit (a batch
+ *         sender can need several slots) and block again, while a later one would have fit.
+ * @return: 1 if a process was made READY, 0 otherwise
+ * PRE: IRQs are disabled
+ */
+int wake_blocked_senders(PCB* receiving_proc)
+{
+	PCB* sender;
+	int woken = 0;
+	
+	while ((sender = (PCB*)pop(&receiving_proc->m_send_waiters)) != NULL) {
+		make_ready(sender);
+		woken = 1;
+	}
+	
+	return woken;
+}
+
+/**
+ * @brief: Moves a process that is no longer blocked onto the ready queue
+ * PRE: IRQs are disabled and the process has already been taken out of the queue it was blocked in
+ */
+void make_ready(PCB* pcb)
+{
+	pcb->m_state = READY;
+	pcb->mp_blocked_pq = NULL;
+	push(ready_pq, (QNode*)pcb, pcb->m_priority);
+}
+
+/**
+ * @brief: Gives a process that was just made READY the chance to preempt the current process
+ * PRE: IRQs are disabled
+ */
+void preempt_current_process(void)
+{
+	if (gp_current_process->m_is_iproc) {
+		g_switch_flag = 1; // Tell the i-process irq handler to release the processor when it it finished
+	}
+	else {
+		k_release_processor(); // Handle preemption
+	}
+}
+
+/**
+ * @brief: Sets the priority the message will be delivered with. Messages start out with
+ *         MSG_PRIORITY_DEFAULT and keep their priority when they are forwarded.
+ * @return: RTX_OK upon success
+ *          RTX_ERR upon failure
+ */
+int k_set_message_priority(void *message, int priority)
+{
+	if (!is_heap_block(message) || priority < HIGH || priority > LOWEST) {
+		return RTX_ERR;
+	}
+	((MSG_ENVELOPE*)k_message_to_envelope(message))->priority = priority;
+	return RTX_OK;
+}
+
 /**
  * @brief: Sends message to process with ID process_id (i.e. add the message defined at message_envelope to process_id's message queue
  * @return: RTX_OK upon success
@@ -408,6 +602,9 @@ int k_send_message(int process_id, void *message){
 	else {
 		// error checking
 		if (message == NULL || process_id < 0) {
+			if (!gp_current_process->m_is_iproc) {
+				__enable_irq();
+			}
 			return RTX_ERR;
 		}
 		
@@ -421,35 +618,115 @@ int k_send_message(int process_id, void *message){
 
 	// error checking
 	if (receiving_proc == NULL) {
+		if (!gp_current_process->m_is_iproc) {
+			__enable_irq();
+		}
+		return RTX_ERR;
+	}
+	
+	// Wait for room in the receiving process's mailbox (i-processes cannot block, so they skip the limit)
+	if (!gp_current_process->m_is_iproc && wait_for_mailbox_space(receiving_proc) == RTX_ERR) {
+		__enable_irq();
 		return RTX_ERR;
 	}
 	
-	// enqueue message_envelope onto the message_q of receiving_proc;
-	enqueue(&receiving_proc->m_message_q, (QNode *)envelope);
+	TRACE(TRACE_SEND, gp_current_process->m_pid, process_id);
+	
+	// If the process receiving the message was blocked waiting for a message,
+	// release the processor so the receiving process has a chance to run
+	if (deliver_message(receiving_proc, envelope)) {
+		preempt_current_process();
+	}
+
+	// Only re-enable irq if the current process is not an i-process
+	if (!gp_current_process->m_is_iproc) {
+		__enable_irq(); // atomic(off)
+	}
+	
+	return RTX_OK;
+}
 
-	// If the process receiving the message is currently blocked waiting for a message,
-	// move the receiving process from the blocked queue to the ready queue, set its state
-	// to READY, then release the processor so the receiving process has a chance to run
-	if (receiving_proc->m_state == BLOCKED_ON_RECEIVE) {
-		if (!remove_at_priority(blocked_waiting_pq, (QNode*)receiving_proc, receiving_proc->m_priority)) {
+/**
+ * @brief: Sends each message in messages to the process with the matching ID in process_ids.
+ *         The current process blocks (before anything is sent) until every blocking mailbox has
+ *         room for all of the messages addressed to it. The messages are then delivered in one
+ *         critical section and the processor is released at most once, after the last message.
+ *         If any of the process IDs or messages are invalid, or a mailbox can't make room for all
+ *         of the messages addressed to it (it is non-blocking, the sender's own, or smaller than
+ *         the number of messages), no messages are sent.
+ * @return: RTX_OK upon success
+ *          RTX_ERR upon failure
+ */
+int k_send_message_batch(int* process_ids, void** messages, int num_messages)
+{
+	int i;
+	int j;
+	int num_to_receive;
+	PCB* receiving_proc;
+	int preempt = 0;
+	
+	__disable_irq(); // atomic(on)
+	
+	// error checking (done up front so that either all or none of the messages are sent)
+	if (process_ids == NULL || messages == NULL || num_messages < 1) {
+		__enable_irq();
+		return RTX_ERR;
+	}
+	for (i = 0; i < num_messages; i++) {
+		if (messages[i] == NULL || get_proc_by_pid(process_ids[i]) == NULL) {
+			__enable_irq();
 			return RTX_ERR;
 		}
-		push(ready_pq, (QNode*)receiving_proc, receiving_proc->m_priority);
-		receiving_proc->m_state = READY;
+	}
+	
+	// Make sure every mailbox has room for all of its messages, so that delivering them never blocks
+	i = 0;
+	while (i < num_messages) {
+		receiving_proc = get_proc_by_pid(process_ids[i]);
 		
-		if (gp_current_process->m_is_iproc) {
-			g_switch_flag = 1; // Tell the i-process irq handler to release the processor when it it finished
+		// Count the messages in the batch going to this process
+		num_to_receive = 0;
+		for (j = 0; j < num_messages; j++) {
+			num_to_receive += process_ids[j] == process_ids[i];
 		}
-		else {
-			k_release_processor(); // Handle preemption
+		
+		if (receiving_proc->m_mailbox_limit > 0
+		        && receiving_proc->m_message_count + num_to_receive > receiving_proc->m_mailbox_limit) {
+			if (receiving_proc->m_mailbox_mode == MAILBOX_NONBLOCKING || receiving_proc == gp_current_process
+			        || num_to_receive > receiving_proc->m_mailbox_limit) {
+				__enable_irq();
+				return RTX_ERR;
+			}
+			
+			// Wait for the receiver to take a message, then check every mailbox again since the others
+			// could have filled up in the meantime
+			gp_current_process->m_state = BLOCKED_ON_SEND;
+			gp_current_process->mp_blocked_pq = &receiving_proc->m_send_waiters;
+			push(&receiving_proc->m_send_waiters, (QNode*)gp_current_process, gp_current_process->m_priority);
+			k_release_processor();
+			__disable_irq(); // k_release_processor turned irq back on
+			i = 0;
+			continue;
 		}
+		i++;
 	}
-
-	// Only re-enable irq if the current process is not an i-process
-	if (!gp_current_process->m_is_iproc) {
-		__enable_irq(); // atomic(off)
+	
+	for (i = 0; i < num_messages; i++) {
+		// set sender and receiver proc_ids in the message_envelope memblock
+		MSG_ENVELOPE* envelope = (MSG_ENVELOPE*)k_message_to_envelope(messages[i]);
+		envelope->sender_pid = gp_current_process->m_pid;
+		envelope->destination_pid = process_ids[i];
+		
+		preempt |= deliver_message(get_proc_by_pid(process_ids[i]), envelope);
+	}
+	
+	// Run the scheduler once now that every message has been delivered
+	if (preempt) {
+		k_release_processor();
 	}
 	
+	__enable_irq(); // atomic(off)
+	
 	return RTX_OK;
 }
 
@@ -465,26 +742,90 @@ void *k_receive_message(int* sender_id)
 	
 	__disable_irq(); // atomic(on)
 	
-	while (q_empty(&gp_current_process->m_message_q)) {
+	while (pq_empty(&gp_current_process->m_message_q)) {
+		TRACE(TRACE_RECV_BLOCKED, gp_current_process->m_pid, 0);
 		gp_current_process->m_state = BLOCKED_ON_RECEIVE;
 		push(blocked_waiting_pq, (QNode*)gp_current_process, gp_current_process->m_priority);
 		k_release_processor();
 	}
 
-	// Get the first envelope in the current process's message queue
-	envelope = (MSG_ENVELOPE*)dequeue(&gp_current_process->m_message_q);
+	// Get the highest priority envelope in the current process's message queue
+	envelope = (MSG_ENVELOPE*)pop(&gp_current_process->m_message_q);
+	gp_current_process->m_message_count--;
 
 	if (sender_id != NULL) {
 		*sender_id = envelope->sender_pid;
 	}
 
 	message = k_envelope_to_message(envelope);
+	
+	// There is now room for a process blocked sending to this one
+	if (wake_blocked_senders(gp_current_process)) {
+		k_release_processor();
+	}
 		
 	__enable_irq(); // atomic(off)
 	
 	return message;
 }
 
+/**
+ * NOTE: BLOCKING receive
+ * @brief: Detaches every message waiting in the current process's message queue, or blocks until a message is received
+ * @return: pointer to the first message in the chain of received messages (use next_message to walk the chain)
+ */
+void *k_receive_all_messages(int* sender_id)
+{
+	MSG_ENVELOPE* envelope;
+	
+	__disable_irq(); // atomic(on)
+	
+	while (pq_empty(&gp_current_process->m_message_q)) {
+		TRACE(TRACE_RECV_BLOCKED, gp_current_process->m_pid, 0);
+		gp_current_process->m_state = BLOCKED_ON_RECEIVE;
+		push(blocked_waiting_pq, (QNode*)gp_current_process, gp_current_process->m_priority);
+		k_release_processor();
+	}
+
+	// Take the whole message queue at once; the envelopes are linked in the order they would have been received
+	envelope = (MSG_ENVELOPE*)pop_all(&gp_current_process->m_message_q);
+	gp_current_process->m_message_count = 0;
+
+	if (sender_id != NULL) {
+		*sender_id = envelope->sender_pid;
+	}
+	
+	// The mailbox is empty again, so every process blocked sending to this one can retry
+	if (wake_blocked_senders(gp_current_process)) {
+		k_release_processor();
+	}
+	
+	__enable_irq(); // atomic(off)
+	
+	return k_envelope_to_message(envelope);
+}
+
+/**
+ * @brief: Gets the message after the given one in a chain returned by k_receive_all_messages.
+ *         This only reads the message headers, so it is called directly rather than through an SVC.
+ * NOTE: Must be called before the given message is sent or released, since either overwrites the link.
+ * @return: pointer to the next message in the chain, or NULL if the given message was the last one
+ */
+void *next_message(void* message, int* sender_id)
+{
+	MSG_ENVELOPE* envelope = ((MSG_ENVELOPE*)k_message_to_envelope(message))->next;
+	
+	if (envelope == NULL) {
+		return NULL;
+	}
+	
+	if (sender_id != NULL) {
+		*sender_id = envelope->sender_pid;
+	}
+	
+	return k_envelope_to_message(envelope);
+}
+
 /**
  * The non-blocking version of k_receive_message for i-processes
  * @return A pointer to the msgbuf of the first message in the process's message queue,
@@ -495,12 +836,14 @@ void* ki_receive_message(int* sender_id)
 	MSG_ENVELOPE* envelope;
 	
 	// If the process has no messages, return a null pointer
-	if (q_empty(&gp_current_process->m_message_q)) {
+	if (pq_empty(&gp_current_process->m_message_q)) {
 		return (void*)0;
 	}
 
-	// Get the first envelope in the current process's message queue
-	envelope = (MSG_ENVELOPE*)dequeue(&gp_current_process->m_message_q);
+	// Get the highest priority envelope in the current process's message queue
+	// (i-process mailboxes cannot be limited, so there are no blocked senders to wake)
+	envelope = (MSG_ENVELOPE*)pop(&gp_current_process->m_message_q);
+	gp_current_process->m_message_count--;
 
 	if (sender_id != NULL) {
 		*sender_id = envelope->sender_pid;
@@ -510,26 +853,38 @@ void* ki_receive_message(int* sender_id)
 	return k_envelope_to_message(envelope);
 }
 
-int k_delayed_send(int process_id, void* message, int delay)
+/**
+ * @brief: Limits the number of messages that can wait in a process's mailbox.
+ *         Senders to a full mailbox block until the receiver takes a message out of it,
+ *         or get RTX_ERR if mode is MAILBOX_NONBLOCKING. I-processes can always send.
+ * @param: limit, the maximum number of waiting messages, or 0 for an unbounded mailbox
+ * @return: RTX_OK upon success
+ *          RTX_ERR upon failure
+ */
+int k_set_mailbox_limit(int pid, int limit, int mode)
 {
-	MSG_ENVELOPE* envelope;
+	PCB* pcb;
 	
 	__disable_irq(); // atomic(on)
 	
-	// error checking
-	if (message == NULL || process_id < 0) {
+	// error checking (i-process mailboxes cannot be limited since the CRT relies on the UART i-process mailbox)
+	if (limit < 0 || (mode != MAILBOX_BLOCKING && mode != MAILBOX_NONBLOCKING)) {
+		__enable_irq();
+		return RTX_ERR;
+	}
+	pcb = get_proc_by_pid(pid);
+	if (pcb == NULL || pcb->m_is_iproc) {
 		__enable_irq();
 		return RTX_ERR;
 	}
 	
-	// Get the pointer to the envelope from the message and set the envelope's data
-	envelope = (MSG_ENVELOPE*)k_message_to_envelope(message);
-	envelope->sender_pid = gp_current_process->m_pid;
-	envelope->destination_pid = process_id;
-	envelope->send_time = get_current_time() + delay;
+	pcb->m_mailbox_limit = limit;
+	pcb->m_mailbox_mode = mode;
 	
-	// Add the envelope to the timer's message queue
-	enqueue(&get_proc_by_pid(PID_TIMER_IPROC)->m_message_q, (QNode*)envelope);
+	// Let blocked senders retry against the new limit (the ones that still don't fit block again)
+	if (wake_blocked_senders(pcb)) {
+		k_release_processor();
+	}
 	
 	__enable_irq(); // atomic(off)
 	
@@ -23,10 +23,21 @@ extern U32 *alloc_stack(U32 size_b);	/* allocate stack for a process */
 extern void __rte(void);				/* pop exception stack frame */
 extern void set_test_procs(void);		/* test process initial set up */
 
+PCB *get_proc_by_pid(int pid);			/* find the PCB of a process */
+int is_blocked(PCB* pcb);				/* whether or not a process is in a blocked state */
+void make_ready(PCB* pcb);				/* move an unblocked process onto the ready queue */
+void preempt_current_process(void);		/* let a newly READY process preempt the current one */
+int change_priority(PCB* pcb, int priority);	/* change the priority the scheduler uses for a process */
+
 int k_get_process_priority(int pid);
 int k_set_process_priority(int pid, int priority);
 
 int k_send_message(int process_id, void *message);
+int k_send_message_batch(int* process_ids, void** messages, int num_messages);
 void *k_receive_message(int* sender_id);
+void *k_receive_all_messages(int* sender_id);
+void *next_message(void* message, int* sender_id);
+int k_set_mailbox_limit(int pid, int limit, int mode);
+int k_set_message_priority(void *message, int priority);
 
 #endif /* ! K_PROCESS_H_ */
@@ -28,6 +28,16 @@
 #define USR_SZ_MEM_BLOCK 0x80    /* heap memory block size is 128 B */
 #define SZ_MEM_BLOCK_HEADER 0x10 /* memory block header size is 16 B */
 #define USR_SZ_STACK 0x12C  /* user proc stack size 300 B */
+#define NUM_SEMAPHORES 8         /* number of counting semaphores the kernel can create */
+#define NUM_MUTEXES 8            /* number of mutexes the kernel can create */
+#define NUM_PORTS 8              /* number of named ports that can be bound */
+#define SZ_PORT_NAME 8           /* port name size, including the null terminator */
+#define NUM_PIPES 4              /* number of pipes */
+#define SZ_PIPE 0x80             /* pipe capacity is 128 B */
+#define SZ_MTEXT 0x6C            /* room for the body of a message in a memory block is 108 B */
+#define NUM_TIMERS 16            /* number of delayed sends that can be waiting at once */
+#define NUM_BULK_BUFFERS 4       /* number of bulk buffers carved out of RAM by memory_init */
+#define SZ_BULK_BUFFER 0x200     /* bulk buffer size is 512 B */
 
 /* Process Priority. The bigger the number is, the lower the priority is*/
 #define HIGH    0
@@ -60,11 +70,37 @@
 #define USER_INPUT 3
 #define COMMAND 4
 #define COUNT_REPORT 5
-#define WAKEUP10 6
+#define CLOCK_TICK 7
+#define FRAMED_INPUT 8 /* command line that arrived on UART0 as a frame, answered with a frame */
+
+/* Framed Console Protocol: FRAME_SOF, a length byte, then that many bytes of payload. Frames aren't echoed.
+ * A command frame's payload is a command line without a null byte. The KCD answers each one with a frame
+ * whose payload is FRAME_REPLY_OK if the command was handed to its process, or FRAME_REPLY_ERR if not.
+ * Whatever the process then displays arrives as plain CRT text, which never contains FRAME_SOF. */
+#define FRAME_SOF 0x02                  /* ASCII STX, which never appears in typed input or display text */
+#define SZ_FRAME_PAYLOAD (SZ_MTEXT - 3) /* longest payload, leaving room for the header and a null terminator */
+#define FRAME_REPLY_OK "OK"
+#define FRAME_REPLY_ERR "ERR"
+
+/* Message Envelope Flags */
+#define MSG_FLAG_BULK 0x01 /* the message owns the bulk buffer in bulk_id (its mtext describes it to the receiver) */
+#define MSG_FLAG_TIMER 0x02 /* the message is the notification of the periodic timer in timer_id */
+
+/* Message Priorities. Messages with a higher priority (lower number) are received first */
+#define MSG_PRIORITY_DEFAULT MEDIUM
+
+/* Mailbox Modes */
+#define MAILBOX_BLOCKING    0 /* senders block while the mailbox is full (sends to your own full mailbox fail) */
+#define MAILBOX_NONBLOCKING 1 /* sends to a full mailbox fail with RTX_ERR */
+
+/* Pipe Modes */
+#define PIPE_BLOCKING    0 /* wait until the whole write fits / until there is something to read */
+#define PIPE_NONBLOCKING 1 /* write or read as much as possible right now */
 
 /*----- Types -----*/
 typedef unsigned char U8;
 typedef unsigned int U32;
+typedef unsigned long long U64;
 
 /* process states */
 typedef enum {
@@ -72,10 +108,39 @@ typedef enum {
 	READY,
 	BLOCKED,
 	BLOCKED_ON_RECEIVE,
+	BLOCKED_ON_SEND,
+	BLOCKED_ON_EVENT,
+	BLOCKED_ON_SEMAPHORE,
+	BLOCKED_ON_MUTEX,
+	BLOCKED_ON_PIPE,
+	SLEEPING,
 	RUNNING,
 	INTERRUPTED
 } PROC_STATE_E;  
 
+/* timer states */
+typedef enum {
+	TIMER_FREE = 0,	/* in the pool of unused timers, or a sleep timer that isn't running */
+	TIMER_ARMED,	/* in the armed list, sorted by expiry time */
+	TIMER_RETIRED	/* stopped periodic timer, freed once its notification is released */
+} TIMER_STATE_E;
+
+/* timer that delivers a message, or wakes a sleeping process, when it expires */
+typedef struct timer
+{
+	struct timer* mp_prev;		/* previous timer in the list the timer is in */
+	struct timer* mp_next;		/* next timer in the list the timer is in */
+	TIMER_STATE_E m_state;		/* state of the timer */
+	U32 m_generation;			/* incremented each time the timer is freed, so stale handles can't reach it */
+	uint32_t m_expiry;			/* time at which the message is delivered */
+	uint32_t m_slack;			/* how much later than m_expiry it may be delivered, so it can go along with other timers */
+	uint32_t m_period;			/* time between expiries of a periodic timer, 0 for a one-shot delayed send */
+	int m_notification_out;		/* whether a periodic timer's message has been delivered and not released yet */
+	int m_missed;				/* periods that expired while the notification was out */
+	struct msg_envelope* mp_envelope;	/* message delivered when the timer expires */
+	struct pcb* mp_sleeper;		/* process woken when the timer expires, if this is the sleep timer of a PCB */
+} TIMER;
+
 /*
   PCB data structure definition.
   You may want to add your own member variables
@@ -86,10 +151,21 @@ typedef struct pcb
 	struct pcb* mp_next;	/* next pcb */
 	uint32_t* mp_sp;		/* stack pointer of the process */
 	int m_pid;				/* process id */
-	int m_priority;
+	int m_priority;			/* priority used for scheduling, raised above m_base_priority by priority inheritance */
+	int m_base_priority;	/* priority assigned to the process */
 	int m_is_iproc;			/* whether or not PCB is iProc */
 	PROC_STATE_E m_state;	/* state of the process */   
-	Queue m_message_q;
+	PriorityQueue m_message_q;	/* received messages, one sub-queue per message priority */
+	int m_message_count;	/* number of messages in m_message_q */
+	int m_mailbox_limit;	/* maximum number of messages in m_message_q, 0 means unbounded */
+	int m_mailbox_mode;		/* MAILBOX_BLOCKING or MAILBOX_NONBLOCKING */
+	PriorityQueue m_send_waiters;		/* processes blocked sending to this process's full mailbox */
+	PriorityQueue* mp_blocked_pq;		/* queue this process is waiting in when BLOCKED_ON_SEND, _SEMAPHORE, _MUTEX or _PIPE */
+	U32 m_event_flags;		/* event flags set for this process and not yet waited on */
+	U32 m_event_wait_mask;	/* event flags this process is waiting for when BLOCKED_ON_EVENT */
+	struct mutex* mp_held_mutexes;		/* list of mutexes this process holds */
+	struct mutex* mp_blocked_mutex;		/* mutex this process is waiting for when BLOCKED_ON_MUTEX */
+	TIMER m_sleep_timer;	/* wakes the process when SLEEPING */
 } PCB;
 
 /* initialization table item */
@@ -104,9 +180,13 @@ typedef struct proc_init
 typedef struct msg_envelope
 {
 	struct msg_envelope* next;
-	int sender_pid;
-	int destination_pid;
+	uint16_t sender_pid;
+	uint16_t destination_pid;
 	uint32_t send_time;
+	U8 priority;            /* delivery priority, HIGH to LOWEST */
+	U8 flags;               /* MSG_FLAG_* bits */
+	U8 timer_id;            /* index of the periodic timer that owns the message, if MSG_FLAG_TIMER is set */
+	U8 bulk_id;             /* index of the bulk buffer the message owns, if MSG_FLAG_BULK is set */
 	int mtype;              /* user defined message type */
 	char mtext[1];         /* body of the message */
 } MSG_ENVELOPE;
@@ -123,6 +203,22 @@ typedef struct mem_block
 	U32 *next_block;
 } MEM_BLOCK;
 
+/* header of a bulk buffer, the SZ_BULK_BUFFER bytes of data follow it */
+typedef struct bulk_buffer
+{
+	struct bulk_buffer* next;	/* next free bulk buffer */
+	int owner_pid;				/* process that owns the buffer, or PID_NULL while it is free */
+	int attached;				/* 1 while a message carries the buffer, which then goes back with the message */
+} BULK_BUFFER;
+
+/* bulk buffer descriptor, stored in the mtext of a message with MSG_FLAG_BULK set.
+   It is only for the receiver; the kernel finds the buffer through the envelope's bulk_id */
+typedef struct bulk_desc
+{
+	void* data;				/* start of the bulk buffer's data */
+	int length;				/* number of bytes of data in use */
+} BULK_DESC;
+
 /* Global variables */
 extern PriorityQueue* blocked_memory_pq;
 extern PriorityQueue* blocked_waiting_pq;
@@ -159,16 +255,42 @@ extern int k_release_memory_block(void *);
 #define release_memory_block(p_mem_blk) _release_memory_block((U32)k_release_memory_block, p_mem_blk)
 extern int _release_memory_block(U32 p_func, void *p_mem_blk) __SVC_0;
 
+extern void *k_request_bulk_buffer(void);
+#define request_bulk_buffer() _request_bulk_buffer((U32)k_request_bulk_buffer)
+extern void *_request_bulk_buffer(U32 p_func) __SVC_0;
+
+extern int k_release_bulk_buffer(void *p_buf);
+#define release_bulk_buffer(p_buf) _release_bulk_buffer((U32)k_release_bulk_buffer, p_buf)
+extern int _release_bulk_buffer(U32 p_func, void *p_buf) __SVC_0;
+
+extern int k_attach_bulk_buffer(void *p_msg, void *p_buf, int length);
+#define attach_bulk_buffer(p_msg, p_buf, length) _attach_bulk_buffer((U32)k_attach_bulk_buffer, p_msg, p_buf, length)
+extern int _attach_bulk_buffer(U32 p_func, void *p_msg, void *p_buf, int length) __SVC_0;
+
 /* IPC Management */
 extern int k_send_message(int pid, void *p_msg);
 #define send_message(pid, p_msg) _send_message((U32)k_send_message, pid, p_msg)
 extern int _send_message(U32 p_func, int pid, void *p_msg) __SVC_0;
 
+extern int k_send_message_batch(int *pids, void **p_msgs, int num_msgs);
+#define send_message_batch(pids, p_msgs, num_msgs) _send_message_batch((U32)k_send_message_batch, pids, p_msgs, num_msgs)
+extern int _send_message_batch(U32 p_func, int *pids, void **p_msgs, int num_msgs) __SVC_0;
+
 extern void *ki_receive_message(int *p_pid);
 extern void *k_receive_message(int *p_pid);
 #define receive_message(p_pid) _receive_message((U32)k_receive_message, p_pid)
 extern void *_receive_message(U32 p_func, void *p_pid) __SVC_0;
 
+extern void *k_receive_all_messages(int *p_pid);
+#define receive_all_messages(p_pid) _receive_all_messages((U32)k_receive_all_messages, p_pid)
+extern void *_receive_all_messages(U32 p_func, void *p_pid) __SVC_0;
+
+extern void *next_message(void *p_msg, int *p_pid); /* walks a receive_all_messages chain, not an SVC */
+
+extern int k_set_mailbox_limit(int pid, int limit, int mode);
+#define set_mailbox_limit(pid, limit, mode) _set_mailbox_limit((U32)k_set_mailbox_limit, pid, limit, mode)
+extern int _set_mailbox_limit(U32 p_func, int pid, int limit, int mode) __SVC_0;
+
 extern void *k_message_to_envelope(MSG_BUF* message);
 #define message_to_envelope(message) _message_to_envelope((U32)k_message_to_envelope, message)
 extern void *_message_to_envelope(U32 p_func, void* message) __SVC_0;
@@ -177,9 +299,104 @@ extern void *k_envelope_to_message(MSG_ENVELOPE* envelope);
 #define envelope_to_message(envelope) _envelope_to_message((U32)k_envelope_to_message, envelope)
 extern void *_envelope_to_message(U32 p_func, void* envelope) __SVC_0;
 
+extern int k_set_message_priority(void *p_msg, int priority);
+#define set_message_priority(p_msg, priority) _set_message_priority((U32)k_set_message_priority, p_msg, priority)
+extern int _set_message_priority(U32 p_func, void *p_msg, int priority) __SVC_0;
+
+/* Synchronization */
+extern int k_set_event_flags(int pid, U32 flags);
+#define set_event_flags(pid, flags) _set_event_flags((U32)k_set_event_flags, pid, flags)
+extern int _set_event_flags(U32 p_func, int pid, U32 flags) __SVC_0;
+
+extern U32 k_wait_event_flags(U32 mask);
+#define wait_event_flags(mask) _wait_event_flags((U32)k_wait_event_flags, mask)
+extern U32 _wait_event_flags(U32 p_func, U32 mask) __SVC_0;
+
+extern int k_create_semaphore(int count);
+#define create_semaphore(count) _create_semaphore((U32)k_create_semaphore, count)
+extern int _create_semaphore(U32 p_func, int count) __SVC_0;
+
+extern int k_wait_semaphore(int sem_id);
+#define wait_semaphore(sem_id) _wait_semaphore((U32)k_wait_semaphore, sem_id)
+extern int _wait_semaphore(U32 p_func, int sem_id) __SVC_0;
+
+extern int k_signal_semaphore(int sem_id);
+#define signal_semaphore(sem_id) _signal_semaphore((U32)k_signal_semaphore, sem_id)
+extern int _signal_semaphore(U32 p_func, int sem_id) __SVC_0;
+
+extern int k_create_mutex(void);
+#define create_mutex() _create_mutex((U32)k_create_mutex)
+extern int _create_mutex(U32 p_func) __SVC_0;
+
+extern int k_lock_mutex(int mutex_id);
+#define lock_mutex(mutex_id) _lock_mutex((U32)k_lock_mutex, mutex_id)
+extern int _lock_mutex(U32 p_func, int mutex_id) __SVC_0;
+
+extern int k_unlock_mutex(int mutex_id);
+#define unlock_mutex(mutex_id) _unlock_mutex((U32)k_unlock_mutex, mutex_id)
+extern int _unlock_mutex(U32 p_func, int mutex_id) __SVC_0;
+
+/* Name Service */
+extern int k_bind_port(const char *name);
+#define bind_port(name) _bind_port((U32)k_bind_port, name)
+extern int _bind_port(U32 p_func, const char *name) __SVC_0;
+
+extern int k_lookup_port(const char *name);
+#define lookup_port(name) _lookup_port((U32)k_lookup_port, name)
+extern int _lookup_port(U32 p_func, const char *name) __SVC_0;
+
+extern int k_send_to_port(int port_id, void *p_msg);
+#define send_to_port(port_id, p_msg) _send_to_port((U32)k_send_to_port, port_id, p_msg)
+extern int _send_to_port(U32 p_func, int port_id, void *p_msg) __SVC_0;
+
+/* Pipes */
+extern int k_create_pipe(void);
+#define create_pipe() _create_pipe((U32)k_create_pipe)
+extern int _create_pipe(U32 p_func) __SVC_0;
+
+extern int k_pipe_write(int pipe_id, const char *buf, int len, int mode);
+#define pipe_write(pipe_id, buf, len, mode) _pipe_write((U32)k_pipe_write, pipe_id, buf, len, mode)
+extern int _pipe_write(U32 p_func, int pipe_id, const char *buf, int len, int mode) __SVC_0;
+
+extern int k_pipe_read(int pipe_id, char *buf, int len, int mode);
+#define pipe_read(pipe_id, buf, len, mode) _pipe_read((U32)k_pipe_read, pipe_id, buf, len, mode)
+extern int _pipe_read(U32 p_func, int pipe_id, char *buf, int len, int mode) __SVC_0;
+
 /* Timing Service */
 extern int k_delayed_send(int pid, void *p_msg, int delay);
 #define delayed_send(pid, p_msg, delay) _delayed_send((U32)k_delayed_send, pid, p_msg, delay)
-extern int _delayed_send(U32 p_func, int pid, void *p_msg, int delay) __SVC_0; 
+extern int _delayed_send(U32 p_func, int pid, void *p_msg, int delay) __SVC_0;
+
+extern int k_delayed_send_slack(int pid, void *p_msg, int delay, int slack);
+#define delayed_send_slack(pid, p_msg, delay, slack) _delayed_send_slack((U32)k_delayed_send_slack, pid, p_msg, delay, slack)
+extern int _delayed_send_slack(U32 p_func, int pid, void *p_msg, int delay, int slack) __SVC_0;
+
+extern int k_cancel_delayed_send(int timer_id);
+#define cancel_delayed_send(timer_id) _cancel_delayed_send((U32)k_cancel_delayed_send, timer_id)
+extern int _cancel_delayed_send(U32 p_func, int timer_id) __SVC_0;
+
+extern int k_reschedule_delayed_send(int timer_id, int delay);
+#define reschedule_delayed_send(timer_id, delay) _reschedule_delayed_send((U32)k_reschedule_delayed_send, timer_id, delay)
+extern int _reschedule_delayed_send(U32 p_func, int timer_id, int delay) __SVC_0;
+
+extern int k_start_periodic_timer(int pid, void *p_msg, int period);
+#define start_periodic_timer(pid, p_msg, period) _start_periodic_timer((U32)k_start_periodic_timer, pid, p_msg, period)
+extern int _start_periodic_timer(U32 p_func, int pid, void *p_msg, int period) __SVC_0;
+
+extern int k_start_periodic_timer_slack(int pid, void *p_msg, int period, int slack);
+#define start_periodic_timer_slack(pid, p_msg, period, slack) _start_periodic_timer_slack((U32)k_start_periodic_timer_slack, pid, p_msg, period, slack)
+extern int _start_periodic_timer_slack(U32 p_func, int pid, void *p_msg, int period, int slack) __SVC_0;
+
+extern int k_stop_periodic_timer(int timer_id);
+#define stop_periodic_timer(timer_id) _stop_periodic_timer((U32)k_stop_periodic_timer, timer_id)
+extern int _stop_periodic_timer(U32 p_func, int timer_id) __SVC_0;
+
+extern int k_sleep(int delay);
+#define sleep(delay) _sleep((U32)k_sleep, delay)
+extern int _sleep(U32 p_func, int delay) __SVC_0; 
+
+extern int k_get_time_us(U64 *p_time);
+#define get_time_us(p_time) _get_time_us((U32)k_get_time_us, p_time)
+extern int _get_time_us(U32 p_func, U64 *p_time) __SVC_0;
 
 #endif // ! K_RTX_H_
@@ -7,20 +7,28 @@
 
 #include "k_rtx_init.h"
 #include "uart.h"
-#include "uart_polling.h"
+#include "uart_log.h"
 #include "i_proc.h"
 #include "k_memory.h"
 #include "k_process.h"
+#include "k_sync.h"
+#include "k_port.h"
+#include "k_pipe.h"
+#include "k_timer.h"
 
 void k_rtx_init(void)
 {
 	__disable_irq();  // atomic(on)
 	uart_irq_init(0); // uart0, interrupt-driven
-	uart1_init();     // uart1, polling
+	log_init();       // uart1, interrupt-driven debug console
 	timer_init(0);    // initialize timer 0
 	timer_init(1);    // initialize timer 1
 	memory_init();    // initialize memory
 	process_init();   // initialize processes (system, user, and interrupt)
+	sync_init();      // initialize synchronization objects
+	port_init();      // initialize named ports
+	pipe_init();      // initialize pipes
+	timer_pool_init(); // initialize delayed send timers
 	__enable_irq();   // atomic(off)
 	
 	/* start the first process */
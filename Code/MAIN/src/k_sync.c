@@ -0,0 +1,402 @@
+/**
+ * @file:   k_sync.c
+ * @brief:  Kernel synchronization primitives: event flags, counting semaphores and mutexes.
+ *          None of them need a memory block. Event flags and semaphores can be signalled
+ *          from i-processes; mutexes belong to the process that locked them.
+ */
+
+#include <LPC17xx.h>
+#include "k_sync.h"
+#include "k_process.h"
+
+extern PCB* gp_current_process;
+
+/* ----- Global Variables ----- */
+SEMAPHORE g_semaphores[NUM_SEMAPHORES]; // Pool of counting semaphores
+MUTEX g_mutexes[NUM_MUTEXES]; // Pool of mutexes
+
+/**
+ * @brief: Initializes every semaphore and mutex as unused
+ */
+void sync_init(void)
+{
+	int i;
+	for (i = 0; i < NUM_SEMAPHORES; i++) {
+		g_semaphores[i].m_in_use = 0;
+		g_semaphores[i].m_count = 0;
+		init_pq(&g_semaphores[i].m_waiters);
+	}
+	for (i = 0; i < NUM_MUTEXES; i++) {
+		g_mutexes[i].m_in_use = 0;
+		g_mutexes[i].mp_owner = NULL;
+		g_mutexes[i].mp_next_held = NULL;
+		init_pq(&g_mutexes[i].m_waiters);
+	}
+}
+
+/**
+ * @brief: Sets event flags for a process. If the process is waiting for any of the flags, it is made READY.
+ * NOTE: Can be called from i-processes.
+ * @return: RTX_OK upon success
+ *          RTX_ERR upon failure
+ */
+int k_set_event_flags(int pid, U32 flags)
+{
+	PCB* pcb;
+	
+	__disable_irq(); // atomic(on)
+	
+	pcb = get_proc_by_pid(pid);
+	if (pcb == NULL) {
+		if (!gp_current_process->m_is_iproc) {
+			__enable_irq();
+		}
+		return RTX_ERR;
+	}
+	
+	pcb->m_event_flags |= flags;
+	
+	// Wake the process if it was waiting for one of the flags that were just set
+	if (pcb->m_state == BLOCKED_ON_EVENT && (pcb->m_event_flags & pcb->m_event_wait_mask)) {
+		make_ready(pcb);
+		preempt_current_process();
+	}
+	
+	// Only re-enable irq if the current process is not an i-process
+	if (!gp_current_process->m_is_iproc) {
+		__enable_irq(); // atomic(off)
+	}
+	
+	return RTX_OK;
+}
+
+/**
+ * NOTE: BLOCKING wait
+ * @brief: Waits until at least one of the event flags in mask has been set for the current process
+ * @return: The flags in mask that were set. They are cleared for the current process.
+ *          0 if mask is empty or the current process is an i-process (which can't block)
+ */
+U32 k_wait_event_flags(U32 mask)
+{
+	U32 flags;
+	
+	__disable_irq(); // atomic(on)
+	
+	if (mask == 0 || gp_current_process->m_is_iproc) {
+		__enable_irq();
+		return 0;
+	}
+	
+	while (!(gp_current_process->m_event_flags & mask)) {
+		gp_current_process->m_state = BLOCKED_ON_EVENT;
+		gp_current_process->m_event_wait_mask = mask;
+		k_release_processor();
+		__disable_irq(); // k_release_processor turned irq back on
+	}
+	
+	// Consume the flags that were waited for
+	flags = gp_current_process->m_event_flags & mask;
+	gp_current_process->m_event_flags &= ~mask;
+	gp_current_process->m_event_wait_mask = 0;
+	
+	__enable_irq(); // atomic(off)
+	
+	return flags;
+}
+
+/**
+ * @brief: Gets the semaphore with the given ID
+ * @return: A pointer to the semaphore, or NULL if the ID is not a created semaphore
+ */
+SEMAPHORE* get_semaphore(int sem_id)
+{
+	if (sem_id < 0 || sem_id >= NUM_SEMAPHORES || !g_semaphores[sem_id].m_in_use) {
+		return NULL;
+	}
+	return &g_semaphores[sem_id];
+}
+
+/**
+ * @brief: Creates a counting semaphore
+ * @param: count, the initial count of the semaphore
+ * @return: The ID of the new semaphore, or RTX_ERR if count is negative or there are no semaphores left
+ */
+int k_create_semaphore(int count)
+{
+	int i;
+	
+	__disable_irq(); // atomic(on)
+	
+	if (count < 0) {
+		__enable_irq();
+		return RTX_ERR;
+	}
+	
+	for (i = 0; i < NUM_SEMAPHORES; i++) {
+		if (!g_semaphores[i].m_in_use) {
+			g_semaphores[i].m_in_use = 1;
+			g_semaphores[i].m_count = count;
+			__enable_irq(); // atomic(off)
+			return i;
+		}
+	}
+	
+	__enable_irq(); // atomic(off)
+	return RTX_ERR;
+}
+
+/**
+ * NOTE: BLOCKING wait
+ * @brief: Decrements the semaphore's count, or blocks until it is signalled if the count is 0
+ * @return: RTX_OK upon success
+ *          RTX_ERR upon failure (including when the current process is an i-process, which can't block)
+ */
+int k_wait_semaphore(int sem_id)
+{
+	SEMAPHORE* sem;
+	
+	__disable_irq(); // atomic(on)
+	
+	sem = get_semaphore(sem_id);
+	if (sem == NULL || gp_current_process->m_is_iproc) {
+		__enable_irq();
+		return RTX_ERR;
+	}
+	
+	if (sem->m_count > 0) {
+		sem->m_count--;
+	}
+	else {
+		// The signaller hands its count straight to the process it wakes up, so there is nothing to decrement after waking
+		gp_current_process->m_state = BLOCKED_ON_SEMAPHORE;
+		gp_current_process->mp_blocked_pq = &sem->m_waiters;
+		push(&sem->m_waiters, (QNode*)gp_current_process, gp_current_process->m_priority);
+		k_release_processor();
+	}
+	
+	__enable_irq(); // atomic(off)
+	
+	return RTX_OK;
+}
+
+/**
+ * @brief: Wakes the highest priority process waiting on the semaphore, or increments its count if nothing is waiting
+ * NOTE: Can be called from i-processes.
+ * @return: RTX_OK upon success
+ *          RTX_ERR upon failure
+ */
+int k_signal_semaphore(int sem_id)
+{
+	SEMAPHORE* sem;
+	PCB* waiter;
+	
+	__disable_irq(); // atomic(on)
+	
+	sem = get_semaphore(sem_id);
+	if (sem == NULL) {
+		if (!gp_current_process->m_is_iproc) {
+			__enable_irq();
+		}
+		return RTX_ERR;
+	}
+	
+	waiter = (PCB*)pop(&sem->m_waiters);
+	if (waiter != NULL) {
+		make_ready(waiter);
+		preempt_current_process();
+	}
+	else {
+		sem->m_count++;
+	}
+	
+	// Only re-enable irq if the current process is not an i-process
+	if (!gp_current_process->m_is_iproc) {
+		__enable_irq(); // atomic(off)
+	}
+	
+	return RTX_OK;
+}
+
+/**
+ * @brief: Gets the mutex with the given ID
+ * @return: A pointer to the mutex, or NULL if the ID is not a created mutex
+ */
+MUTEX* get_mutex(int mutex_id)
+{
+	if (mutex_id < 0 || mutex_id >= NUM_MUTEXES || !g_mutexes[mutex_id].m_in_use) {
+		return NULL;
+	}
+	return &g_mutexes[mutex_id];
+}
+
+/**
+ * @brief: Gets the priority a process should run at: its own priority, or the priority
+ *         of the highest priority process waiting on any of the mutexes it holds
+ * @return: The effective priority of the process
+ */
+int effective_priority(PCB* pcb)
+{
+	int priority = pcb->m_base_priority;
+	MUTEX* mutex;
+	PCB* waiter;
+	
+	for (mutex = pcb->mp_held_mutexes; mutex != NULL; mutex = mutex->mp_next_held) {
+		waiter = (PCB*)top(&mutex->m_waiters);
+		if (waiter != NULL && waiter->m_priority < priority) {
+			priority = waiter->m_priority;
+		}
+	}
+	
+	return priority;
+}
+
+/**
+ * @brief: Recomputes the effective priority of the process, then of the owner of the mutex
+ *         it is waiting for, and so on down the chain until a priority stops changing
+ * @return: 1 upon success, 0 if a process could not be moved within its queue
+ * PRE: IRQs are disabled
+ */
+int update_priority_chain(PCB* pcb)
+{
+	int priority;
+	
+	while (pcb != NULL) {
+		priority = effective_priority(pcb);
+		if (priority == pcb->m_priority) {
+			break;
+		}
+		if (!change_priority(pcb, priority)) {
+			return 0;
+		}
+		pcb = pcb->m_state == BLOCKED_ON_MUTEX ? pcb->mp_blocked_mutex->mp_owner : NULL;
+	}
+	
+	return 1;
+}
+
+/**
+ * @brief: Removes a mutex from the list of mutexes held by its owner
+ */
+void remove_held_mutex(PCB* owner, MUTEX* mutex)
+{
+	MUTEX** p_link = &owner->mp_held_mutexes;
+	
+	while (*p_link != NULL) {
+		if (*p_link == mutex) {
+			*p_link = mutex->mp_next_held;
+			break;
+		}
+		p_link = &(*p_link)->mp_next_held;
+	}
+	mutex->mp_next_held = NULL;
+}
+
+/**
+ * @brief: Creates an unlocked mutex
+ * @return: The ID of the new mutex, or RTX_ERR if there are no mutexes left
+ */
+int k_create_mutex(void)
+{
+	int i;
+	
+	__disable_irq(); // atomic(on)
+	
+	for (i = 0; i < NUM_MUTEXES; i++) {
+		if (!g_mutexes[i].m_in_use) {
+			g_mutexes[i].m_in_use = 1;
+			g_mutexes[i].mp_owner = NULL;
+			__enable_irq(); // atomic(off)
+			return i;
+		}
+	}
+	
+	__enable_irq(); // atomic(off)
+	return RTX_ERR;
+}
+
+/**
+ * NOTE: BLOCKING lock
+ * @brief: Locks the mutex, or blocks until it is handed over if another process holds it.
+ *         While blocked, the holder (and whatever it is blocked on) inherits the current
+ *         process's priority, so medium priority processes can't keep it from unlocking.
+ * @return: RTX_OK upon success
+ *          RTX_ERR upon failure (including locking a mutex the current process already holds)
+ */
+int k_lock_mutex(int mutex_id)
+{
+	MUTEX* mutex;
+	
+	__disable_irq(); // atomic(on)
+	
+	mutex = get_mutex(mutex_id);
+	if (mutex == NULL || gp_current_process->m_is_iproc || mutex->mp_owner == gp_current_process) {
+		__enable_irq();
+		return RTX_ERR;
+	}
+	
+	if (mutex->mp_owner == NULL) {
+		mutex->mp_owner = gp_current_process;
+		mutex->mp_next_held = gp_current_process->mp_held_mutexes;
+		gp_current_process->mp_held_mutexes = mutex;
+	}
+	else {
+		// The unlocker hands the mutex straight to the process it wakes up, so it is held after waking
+		gp_current_process->m_state = BLOCKED_ON_MUTEX;
+		gp_current_process->mp_blocked_pq = &mutex->m_waiters;
+		gp_current_process->mp_blocked_mutex = mutex;
+		push(&mutex->m_waiters, (QNode*)gp_current_process, gp_current_process->m_priority);
+		update_priority_chain(mutex->mp_owner);
+		k_release_processor();
+	}
+	
+	__enable_irq(); // atomic(off)
+	
+	return RTX_OK;
+}
+
+/**
+ * @brief: Unlocks a mutex held by the current process, handing it to the highest priority
+ *         process waiting on it, and drops any priority inherited through it
+ * @return: RTX_OK upon success
+ *          RTX_ERR upon failure (including unlocking a mutex the current process doesn't hold)
+ */
+int k_unlock_mutex(int mutex_id)
+{
+	MUTEX* mutex;
+	PCB* waiter;
+	
+	__disable_irq(); // atomic(on)
+	
+	mutex = get_mutex(mutex_id);
+	if (mutex == NULL || mutex->mp_owner != gp_current_process) {
+		__enable_irq();
+		return RTX_ERR;
+	}
+	
+	remove_held_mutex(gp_current_process, mutex);
+	
+	waiter = (PCB*)pop(&mutex->m_waiters);
+	if (waiter != NULL) {
+		mutex->mp_owner = waiter;
+		mutex->mp_next_held = waiter->mp_held_mutexes;
+		waiter->mp_held_mutexes = mutex;
+		waiter->mp_blocked_mutex = NULL;
+		make_ready(waiter);
+		// The new owner inherits from the processes still waiting on the mutex
+		update_priority_chain(waiter);
+	}
+	else {
+		mutex->mp_owner = NULL;
+	}
+	
+	// Drop back to the priority the current process had before it inherited through this mutex
+	update_priority_chain(gp_current_process);
+	
+	if (waiter != NULL) {
+		k_release_processor();
+	}
+	
+	__enable_irq(); // atomic(off)
+	
+	return RTX_OK;
+}
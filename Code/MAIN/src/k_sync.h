@@ -0,0 +1,47 @@
+/**
+ * @file:   k_sync.h
+ * @brief:  Kernel synchronization primitives header file
+ */
+
+#ifndef K_SYNC_H_
+#define K_SYNC_H_
+
+#include "k_rtx.h"
+
+/* ----- Types ----- */
+
+/* counting semaphore */
+typedef struct semaphore
+{
+	int m_in_use;				/* whether or not the semaphore has been created */
+	int m_count;				/* number of times the semaphore can be waited on without blocking */
+	PriorityQueue m_waiters;	/* processes blocked waiting on the semaphore */
+} SEMAPHORE;
+
+/* mutex with priority inheritance */
+typedef struct mutex
+{
+	int m_in_use;				/* whether or not the mutex has been created */
+	PCB* mp_owner;				/* process holding the mutex, NULL if unlocked */
+	PriorityQueue m_waiters;	/* processes blocked waiting to lock the mutex */
+	struct mutex* mp_next_held;	/* next mutex held by the same owner */
+} MUTEX;
+
+/* ----- Functions ----- */
+
+void sync_init(void);						/* initialize the synchronization objects */
+
+int k_set_event_flags(int pid, U32 flags);
+U32 k_wait_event_flags(U32 mask);
+
+int k_create_semaphore(int count);
+int k_wait_semaphore(int sem_id);
+int k_signal_semaphore(int sem_id);
+
+int update_priority_chain(PCB* pcb);		/* recompute inherited priorities starting from pcb */
+
+int k_create_mutex(void);
+int k_lock_mutex(int mutex_id);
+int k_unlock_mutex(int mutex_id);
+
+#endif /* ! K_SYNC_H_ */
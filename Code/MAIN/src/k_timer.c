@@ -0,0 +1,528 @@
+/**
+ * @file:   k_timer.c
+ * @brief:  Kernel delayed send and periodic timers. Each timer comes from a fixed pool.
+ *          The handle returned by delayed_send finds the timer directly, so a message that is
+ *          no longer wanted can be cancelled or rescheduled before it is delivered.
+ *          A periodic timer keeps advancing its deadline by its period, so it doesn't drift,
+ *          and it delivers the same message every time it is released.
+ *          A timer with slack may fire up to slack milliseconds late, so that timers whose windows
+ *          overlap are delivered in one pass of the timer i-process.
+ */
+
+#include <LPC17xx.h>
+#include "k_timer.h"
+#include "k_process.h"
+#include "i_proc.h"
+#include "trace.h"
+
+extern PCB* gp_current_process;
+
+/* ----- Global Variables ----- */
+TIMER g_timers[NUM_TIMERS]; // Pool of timers
+TIMER* gp_free_timers;      // Singly linked list of unused timers
+TimerList g_armed_timers;   // Timers sorted by expiry time, soonest first
+
+/**
+ * @brief: Puts every timer into the pool of unused timers
+ */
+void timer_pool_init(void)
+{
+	int i;
+	
+	gp_free_timers = NULL;
+	for (i = NUM_TIMERS - 1; i >= 0; i--) {
+		g_timers[i].mp_prev = NULL;
+		g_timers[i].mp_next = gp_free_timers;
+		g_timers[i].m_state = TIMER_FREE;
+		g_timers[i].m_generation = 1;
+		g_timers[i].m_period = 0;
+		g_timers[i].mp_sleeper = NULL;
+		g_timers[i].mp_envelope = NULL;
+		gp_free_timers = &g_timers[i];
+	}
+	
+	g_armed_timers.mp_first = g_armed_timers.mp_last = NULL;
+}
+
+/**
+ * @brief: Inserts the timer into the list after every timer whose deadline is at or before its deadline
+ */
+void insert_timer(TimerList* list, TIMER* timer)
+{
+	TIMER* iter = list->mp_last;
+	
+	// Search from the back since new timers usually expire after the ones already waiting
+	while (iter != NULL && TIME_AFTER(TIMER_DEADLINE(iter), TIMER_DEADLINE(timer))) {
+		iter = iter->mp_prev;
+	}
+	
+	if (iter == NULL) { // Insert at the front
+		timer->mp_prev = NULL;
+		timer->mp_next = list->mp_first;
+		if (list->mp_first == NULL) {
+			list->mp_last = timer;
+		}
+		else {
+			list->mp_first->mp_prev = timer;
+		}
+		list->mp_first = timer;
+	}
+	else { // Insert after iter
+		timer->mp_prev = iter;
+		timer->mp_next = iter->mp_next;
+		if (iter->mp_next == NULL) {
+			list->mp_last = timer;
+		}
+		else {
+			iter->mp_next->mp_prev = timer;
+		}
+		iter->mp_next = timer;
+	}
+}
+
+/**
+ * @brief: Removes the timer from the list it is in
+ */
+void unlink_timer(TimerList* list, TIMER* timer)
+{
+	if (timer->mp_prev == NULL) {
+		list->mp_first = timer->mp_next;
+	}
+	else {
+		timer->mp_prev->mp_next = timer->mp_next;
+	}
+	if (timer->mp_next == NULL) {
+		list->mp_last = timer->mp_prev;
+	}
+	else {
+		timer->mp_next->mp_prev = timer->mp_prev;
+	}
+	timer->mp_prev = timer->mp_next = NULL;
+}
+
+/**
+ * @brief: Takes a timer out of the pool of unused timers
+ * @return: A pointer to the timer, or NULL if every timer is in use
+ */
+TIMER* alloc_timer(void)
+{
+	TIMER* timer = gp_free_timers;
+	
+	if (timer != NULL) {
+		gp_free_timers = timer->mp_next;
+		timer->m_period = 0;
+		timer->m_slack = 0;
+		timer->m_notification_out = 0;
+		timer->m_missed = 0;
+	}
+	return timer;
+}
+
+/**
+ * @brief: Gets the handle of a timer
+ */
+int get_timer_id(TIMER* timer)
+{
+	return (int)((timer->m_generation << TIMER_HANDLE_SHIFT) | (timer - g_timers));
+}
+
+/**
+ * @brief: Gets the generation a timer moves to when its handle is invalidated
+ */
+U32 next_generation(U32 generation)
+{
+	generation = (generation + 1) & TIMER_GENERATION_MASK;
+	return generation == 0 ? 1 : generation;
+}
+
+/**
+ * @brief: Returns a timer to the pool of unused timers, invalidating its handle
+ */
+void free_timer(TIMER* timer)
+{
+	timer->m_state = TIMER_FREE;
+	timer->m_generation = next_generation(timer->m_generation);
+	timer->mp_envelope = NULL;
+	timer->mp_prev = NULL;
+	timer->mp_next = gp_free_timers;
+	gp_free_timers = timer;
+}
+
+/**
+ * @brief: Gets the timer a handle refers to
+ * @return: A pointer to the timer, or NULL if the handle doesn't refer to a running timer
+ */
+TIMER* get_timer(int timer_id)
+{
+	TIMER* timer;
+	
+	if (timer_id < 0 || (timer_id & ((1 << TIMER_HANDLE_SHIFT) - 1)) >= NUM_TIMERS) {
+		return NULL;
+	}
+	
+	timer = &g_timers[timer_id & ((1 << TIMER_HANDLE_SHIFT) - 1)];
+	if (timer->m_state == TIMER_FREE || timer->m_state == TIMER_RETIRED
+	        || timer->m_generation != (U32)timer_id >> TIMER_HANDLE_SHIFT) {
+		return NULL;
+	}
+	return timer;
+}
+
+/**
+ * @brief: Delivers the message of an armed timer that has expired, taking it out of the armed timers
+ */
+void fire_timer(TIMER* timer, uint32_t now)
+{
+	MSG_ENVELOPE* envelope = timer->mp_envelope;
+	int periods;
+	
+	unlink_timer(&g_armed_timers, timer);
+	
+	TRACE(TRACE_TIMER_FIRE, PID_TIMER_IPROC, timer->mp_sleeper != NULL ? timer->mp_sleeper->m_pid : envelope->destination_pid);
+	
+	if (timer->mp_sleeper != NULL) { // Sleep timer embedded in a PCB
+		timer->m_state = TIMER_FREE;
+		make_ready(timer->mp_sleeper);
+		preempt_current_process();
+		return;
+	}
+	
+	if (timer->m_period == 0) { // One-shot delayed send
+		free_timer(timer);
+		k_send_message(envelope->destination_pid, envelope);
+		return;
+	}
+	
+	// Advance the deadline from the previous deadline rather than from now so the timer doesn't drift,
+	// counting any periods that went by without the timer i-process running
+	periods = 0;
+	do {
+		timer->m_expiry += timer->m_period;
+		periods++;
+	}
+	while (!TIME_AFTER(timer->m_expiry, now));
+	insert_timer(&g_armed_timers, timer);
+	
+	// The notification can only be in one place at a time, so count the expiry for the next delivery if it is out
+	timer->m_missed += periods;
+	if (!timer->m_notification_out) {
+		*(int*)((MSG_BUF*)k_envelope_to_message(envelope))->mtext = timer->m_missed;
+		timer->m_notification_out = 1;
+		if (k_send_message(envelope->destination_pid, envelope) == RTX_OK) {
+			timer->m_missed = 0;
+		}
+		else {
+			timer->m_notification_out = 0;
+		}
+	}
+}
+
+/**
+ * @brief: Delivers the message of every armed timer that has expired by now, once the first
+ *         timer reaches the end of its slack. Timers whose slack windows overlap are delivered
+ *         in the same pass, so the receivers are woken together.
+ * NOTE: Called by the timer i-process
+ */
+void fire_expired_timers(uint32_t now)
+{
+	TIMER* timer = g_armed_timers.mp_first;
+	TIMER* next;
+	uint32_t horizon;
+	
+	// Armed timers are sorted by deadline, so nothing has to fire until the first one's deadline
+	if (timer == NULL || TIME_AFTER(TIMER_DEADLINE(timer), now)) {
+		return;
+	}
+	
+	// A timer's deadline is at most TIMER_MAX_SLACK after its expiry, so no timer past the horizon has expired
+	horizon = now + TIMER_MAX_SLACK;
+	while (timer != NULL && !TIME_AFTER(TIMER_DEADLINE(timer), horizon)) {
+		next = timer->mp_next;
+		if (!TIME_AFTER(timer->m_expiry, now)) {
+			fire_timer(timer, now);
+		}
+		timer = next;
+	}
+}
+
+/**
+ * @brief: Takes back the notification of a periodic timer when it is released
+ * @return: 1 if the timer keeps the envelope for its next expiry,
+ *          0 if the timer has been stopped, in which case the envelope should go back to the heap
+ * PRE: IRQs are disabled and the envelope has MSG_FLAG_TIMER set
+ */
+int reclaim_timer_notification(MSG_ENVELOPE* envelope)
+{
+	TIMER* timer = &g_timers[envelope->timer_id];
+	
+	if (timer->m_state == TIMER_RETIRED) {
+		envelope->flags &= ~MSG_FLAG_TIMER;
+		free_timer(timer);
+		return 0;
+	}
+	
+	timer->m_notification_out = 0;
+	return 1;
+}
+
+/**
+ * @brief: Sends a message to a process after delay milliseconds
+ * @return: A handle to the timer holding the message, for cancel_delayed_send and reschedule_delayed_send
+ *          RTX_OK if delay is 0, since the message is sent right away
+ *          RTX_ERR upon failure
+ */
+int k_delayed_send(int process_id, void* message, int delay)
+{
+	return k_delayed_send_slack(process_id, message, delay, 0);
+}
+
+/**
+ * @brief: Sends a message to a process after delay milliseconds, or up to slack milliseconds later
+ *         so it can be delivered along with other timers
+ * @return: A handle to the timer holding the message, for cancel_delayed_send and reschedule_delayed_send
+ *          RTX_OK if delay is 0, since the message is sent right away
+ *          RTX_ERR upon failure
+ */
+int k_delayed_send_slack(int process_id, void* message, int delay, int slack)
+{
+	MSG_ENVELOPE* envelope;
+	TIMER* timer;
+	
+	if (slack < 0 || slack > TIMER_MAX_SLACK) {
+		return RTX_ERR;
+	}
+	
+	// There is nothing to wait for, so don't hold the message until the next tick
+	if (delay == 0) {
+		return k_send_message(process_id, message);
+	}
+	
+	__disable_irq(); // atomic(on)
+	
+	// error checking
+	if (message == NULL || process_id < 0 || delay < 0 || gp_free_timers == NULL) {
+		__enable_irq();
+		return RTX_ERR;
+	}
+	
+	// Get the pointer to the envelope from the message and set the envelope's data
+	envelope = (MSG_ENVELOPE*)k_message_to_envelope(message);
+	envelope->sender_pid = gp_current_process->m_pid;
+	envelope->destination_pid = process_id;
+	envelope->send_time = get_current_time() + delay;
+	
+	// Hand the message to a timer, in order of expiry so the timer i-process only has to look at the front
+	timer = alloc_timer();
+	timer->m_state = TIMER_ARMED;
+	timer->m_expiry = envelope->send_time;
+	timer->m_slack = slack;
+	timer->mp_envelope = envelope;
+	insert_timer(&g_armed_timers, timer);
+	
+	__enable_irq(); // atomic(off)
+	
+	return get_timer_id(timer);
+}
+
+/**
+ * @brief: Cancels a delayed send that hasn't been delivered yet. The message is released.
+ * @return: RTX_OK upon success
+ *          RTX_ERR if the handle is invalid or the message was already delivered
+ */
+int k_cancel_delayed_send(int timer_id)
+{
+	TIMER* timer;
+	MSG_ENVELOPE* envelope;
+	
+	__disable_irq(); // atomic(on)
+	
+	timer = get_timer(timer_id);
+	if (timer == NULL || timer->m_period != 0) {
+		__enable_irq();
+		return RTX_ERR;
+	}
+	
+	unlink_timer(&g_armed_timers, timer);
+	envelope = timer->mp_envelope;
+	free_timer(timer);
+	
+	// Give the message's memory block straight back to the heap
+	return k_release_memory_block(k_envelope_to_message(envelope));
+}
+
+/**
+ * @brief: Changes a delayed send that hasn't been delivered yet to be delivered delay milliseconds from now
+ * @return: RTX_OK upon success
+ *          RTX_ERR if the handle is invalid or the message was already delivered
+ */
+int k_reschedule_delayed_send(int timer_id, int delay)
+{
+	TIMER* timer;
+	
+	__disable_irq(); // atomic(on)
+	
+	timer = get_timer(timer_id);
+	if (timer == NULL || timer->m_period != 0 || delay < 0) {
+		__enable_irq();
+		return RTX_ERR;
+	}
+	
+	timer->m_expiry = get_current_time() + delay;
+	timer->mp_envelope->send_time = timer->m_expiry;
+	
+	// Armed timers are kept sorted, so move it to its new place in the list
+	unlink_timer(&g_armed_timers, timer);
+	insert_timer(&g_armed_timers, timer);
+	
+	__enable_irq(); // atomic(off)
+	
+	return RTX_OK;
+}
+
+/**
+ * @brief: Sends a message to a process every period milliseconds, starting period milliseconds from now.
+ *         The same message is delivered every time, so the receiver must release it before the next
+ *         expiry. The first int of its mtext is set to the number of periods since the previous delivery.
+ * @return: A handle to the timer for stop_periodic_timer
+ *          RTX_ERR upon failure
+ */
+int k_start_periodic_timer(int process_id, void* message, int period)
+{
+	return k_start_periodic_timer_slack(process_id, message, period, 0);
+}
+
+/**
+ * @brief: Starts a periodic timer whose notifications may each be delivered up to slack milliseconds
+ *         late, so they can be delivered along with other timers. The period is still kept from the
+ *         expiry, so the lateness doesn't accumulate.
+ * @return: A handle to the timer for stop_periodic_timer
+ *          RTX_ERR upon failure
+ */
+int k_start_periodic_timer_slack(int process_id, void* message, int period, int slack)
+{
+	MSG_ENVELOPE* envelope;
+	PCB* pcb;
+	TIMER* timer;
+	
+	__disable_irq(); // atomic(on)
+	
+	// error checking (the notification goes back to the timer when it is released, so it must be a process that releases it)
+	pcb = get_proc_by_pid(process_id);
+	if (message == NULL || pcb == NULL || pcb->m_is_iproc || period <= 0
+	        || slack < 0 || slack > TIMER_MAX_SLACK || gp_free_timers == NULL) {
+		__enable_irq();
+		return RTX_ERR;
+	}
+	
+	envelope = (MSG_ENVELOPE*)k_message_to_envelope(message);
+	envelope->sender_pid = gp_current_process->m_pid;
+	envelope->destination_pid = process_id;
+	
+	timer = alloc_timer();
+	timer->m_state = TIMER_ARMED;
+	timer->m_period = period;
+	timer->m_expiry = get_current_time() + period;
+	timer->m_slack = slack;
+	timer->mp_envelope = envelope;
+	insert_timer(&g_armed_timers, timer);
+	
+	// Released notifications come back to the timer instead of the heap
+	envelope->flags |= MSG_FLAG_TIMER;
+	envelope->timer_id = (U8)(timer - g_timers);
+	
+	__enable_irq(); // atomic(off)
+	
+	return get_timer_id(timer);
+}
+
+/**
+ * @brief: Stops a periodic timer. If its notification is waiting to be released, the notification
+ *         goes back to the heap when it is released. Otherwise it is released now.
+ * @return: RTX_OK upon success
+ *          RTX_ERR if the handle is not a running periodic timer
+ */
+int k_stop_periodic_timer(int timer_id)
+{
+	TIMER* timer;
+	MSG_ENVELOPE* envelope;
+	
+	__disable_irq(); // atomic(on)
+	
+	timer = get_timer(timer_id);
+	if (timer == NULL || timer->m_period == 0) {
+		__enable_irq();
+		return RTX_ERR;
+	}
+	
+	unlink_timer(&g_armed_timers, timer);
+	
+	if (timer->m_notification_out) {
+		// Invalidate the handle now, but keep the timer until its notification comes back
+		timer->m_state = TIMER_RETIRED;
+		timer->m_generation = next_generation(timer->m_generation);
+		__enable_irq(); // atomic(off)
+		return RTX_OK;
+	}
+	
+	envelope = timer->mp_envelope;
+	envelope->flags &= ~MSG_FLAG_TIMER;
+	free_timer(timer);
+	
+	// Give the notification's memory block straight back to the heap
+	return k_release_memory_block(k_envelope_to_message(envelope));
+}
+
+/**
+ * NOTE: BLOCKING sleep
+ * @brief: Puts the current process to sleep for delay milliseconds, using the timer in its PCB
+ * @return: RTX_OK upon success
+ *          RTX_ERR upon failure
+ */
+int k_sleep(int delay)
+{
+	TIMER* timer;
+	
+	__disable_irq(); // atomic(on)
+	
+	if (delay < 0 || gp_current_process->m_is_iproc) {
+		__enable_irq();
+		return RTX_ERR;
+	}
+	
+	if (delay > 0) {
+		timer = &gp_current_process->m_sleep_timer;
+		timer->m_state = TIMER_ARMED;
+		timer->m_expiry = get_current_time() + delay;
+		insert_timer(&g_armed_timers, timer);
+		gp_current_process->m_state = SLEEPING;
+	}
+	
+	// A delay of 0 just gives other processes at the same priority a chance to run
+	k_release_processor();
+	
+	return RTX_OK;
+}
+
+/**
+ * @brief: Reads the 64-bit monotonic clock, in microseconds since the timer started
+ * NOTE: Can be called from i-processes.
+ * @return: RTX_OK upon success
+ *          RTX_ERR upon failure
+ */
+int k_get_time_us(U64* p_time)
+{
+	if (p_time == NULL) {
+		return RTX_ERR;
+	}
+	
+	__disable_irq(); // atomic(on)
+	
+	*p_time = get_monotonic_time_us();
+	
+	// Only re-enable irq if the current process is not an i-process
+	if (!gp_current_process->m_is_iproc) {
+		__enable_irq(); // atomic(off)
+	}
+	
+	return RTX_OK;
+}
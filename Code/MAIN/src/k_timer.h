@@ -0,0 +1,48 @@
+/**
+ * @file:   k_timer.h
+ * @brief:  Kernel delayed send timers header file
+ */
+
+#ifndef K_TIMER_H_
+#define K_TIMER_H_
+
+#include "k_rtx.h"
+
+/* ----- Definitions ----- */
+#define TIMER_HANDLE_SHIFT 8			/* a handle is the timer's generation shifted above its index */
+#define TIMER_GENERATION_MASK 0x7FFFFF	/* keeps handles positive, and generations start at 1 so no handle is RTX_OK */
+
+/* Wrap-safe comparison of millisecond deadlines, correct while they are less than about 24 days apart */
+#define TIME_AFTER(a, b) ((int32_t)((uint32_t)(a) - (uint32_t)(b)) > 0)
+
+#define TIMER_MAX_SLACK 1000	/* most a timer may be delivered after its expiry, in ms */
+
+/* Latest time at which the timer must fire. Armed timers are sorted by it. */
+#define TIMER_DEADLINE(timer) ((timer)->m_expiry + (timer)->m_slack)
+
+/* ----- Types ----- */
+
+/* doubly linked list of timers */
+typedef struct timer_list
+{
+	TIMER* mp_first;
+	TIMER* mp_last;
+} TimerList;
+
+/* ----- Functions ----- */
+
+void timer_pool_init(void);					/* initialize the pool of timers */
+void fire_expired_timers(uint32_t now);		/* deliver the messages of the timers that have expired */
+int reclaim_timer_notification(MSG_ENVELOPE* envelope);	/* take back a released periodic timer notification */
+
+int k_delayed_send(int process_id, void* message, int delay);
+int k_delayed_send_slack(int process_id, void* message, int delay, int slack);
+int k_cancel_delayed_send(int timer_id);
+int k_reschedule_delayed_send(int timer_id, int delay);
+int k_start_periodic_timer(int process_id, void* message, int period);
+int k_start_periodic_timer_slack(int process_id, void* message, int period, int slack);
+int k_stop_periodic_timer(int timer_id);
+int k_sleep(int delay);
+int k_get_time_us(U64* p_time);
+
+#endif /* ! K_TIMER_H_ */
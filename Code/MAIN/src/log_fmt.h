@@ -0,0 +1,51 @@
+/**
+ * @file:   log_fmt.h
+ * @brief:  Deferred-format logging. The target only records which format string to
+ *          use and the raw argument words, and tools/trace_decode.c does the formatting
+ *          with the same table, so a log call costs a few stores instead of a printf.
+ *
+ * NOTE:
+ * A record is LOG_SYNC, the format id, the number of arguments and a padding byte,
+ * followed by each argument as a little endian 32-bit word. Formats may only use
+ * conversions that take an int sized argument (%d %u %x %c).
+ * Like kernel trace records, log records are binary, so they are only sent when DEBUG_TRACE
+ * says UART1 is being captured for the decoder. Otherwise LOG0..LOG3 compile to nothing.
+ * This header is also compiled into the host decoder, so it only depends on stdint.h.
+ */
+
+#ifndef LOG_FMT_H_
+#define LOG_FMT_H_
+
+#include <stdint.h>
+
+#define LOG_SYNC 0xA6		/* first byte of every log record */
+#define LOG_MAX_ARGS 3		/* most argument words a log record carries */
+
+/* X(id, format): every format string that can be logged */
+#define LOG_FORMATS(X) \
+	X(LOG_UART_ENTER,   "Entering UART i-proc") \
+	X(LOG_UART_CHAR,    "Reading a char = %c") \
+	X(LOG_UART_UNKNOWN, "Should not get here! IIR interrupt id %u")
+
+#define LOG_ENUM_ENTRY(id, format) id,
+typedef enum {
+	LOG_FORMATS(LOG_ENUM_ENTRY)
+	NUM_LOG_FORMATS
+} LOG_FORMAT_E;
+#undef LOG_ENUM_ENTRY
+
+#ifdef DEBUG_TRACE
+#define LOG0(id)          log_deferred(id, 0, 0, 0, 0)
+#define LOG1(id, a)       log_deferred(id, 1, (uint32_t)(a), 0, 0)
+#define LOG2(id, a, b)    log_deferred(id, 2, (uint32_t)(a), (uint32_t)(b), 0)
+#define LOG3(id, a, b, c) log_deferred(id, 3, (uint32_t)(a), (uint32_t)(b), (uint32_t)(c))
+#else
+#define LOG0(id)
+#define LOG1(id, a)
+#define LOG2(id, a, b)
+#define LOG3(id, a, b, c)
+#endif /* DEBUG_TRACE */
+
+void log_deferred(uint8_t id, uint8_t num_args, uint32_t a0, uint32_t a1, uint32_t a2); /* queue a log record */
+
+#endif /* ! LOG_FMT_H_ */
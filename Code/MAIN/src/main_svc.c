@@ -6,9 +6,9 @@
  * NOTE: standard C library is not allowed in the final kernel code.
  *       A tiny printf function for embedded application development
  *       taken from http://www.sparetimelabs.com/tinyprintf/tinyprintf.php
- *       is configured to use UART0 to output when DEBUG_0 is defined.
+ *       is configured to use the UART1 debug console when DEBUG_0 is defined.
  *       Check target option->C/C++ to see the DEBUG_0 definition.
- *       Note that init_printf(NULL, putc) must be called to initialize 
+ *       Note that init_printf(NULL, log_putc) must be called to initialize 
  *       the printf function.
  */
 
@@ -16,11 +16,11 @@
 #include <system_LPC17xx.h>
 #include "rtx.h"
 #ifdef DEBUG_0
-#include "uart_polling.h"
+#include "uart_log.h"
 #include "printf.h"
 #else
 	#ifdef DEBUG_1
-		#include "uart_polling.h"
+		#include "uart_log.h"
 		#include "printf.h"
 	#endif /* DEBUG_1 */
 #endif /* DEBUG_0 */
@@ -30,10 +30,10 @@ int main()
 	/* CMSIS system initialization */
 	SystemInit(); 
 #ifdef DEBUG_0
-	init_printf(NULL, putc);
+	init_printf(NULL, log_putc);
 #else
 	#ifdef DEBUG_1
-		init_printf(NULL, putc);
+		init_printf(NULL, log_putc);
 	#endif /* DEBUG_1 */
 #endif /* DEBUG_0 */
 	
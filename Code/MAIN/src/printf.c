@@ -30,6 +30,7 @@
  */
 
 #include "printf.h"
+#include "utils.h"
 
 typedef void (*putcf) (void*,char);
 static putcf stdout_putf;
@@ -67,33 +68,6 @@ static void li2a (long num, char * bf)
 
 #endif
 
-static void ui2a(unsigned int num, unsigned int base, int uc,char * bf)
-	{
-	int n=0;
-	unsigned int d=1;
-	while (num/d >= base)
-		d*=base;		
-	while (d!=0) {
-		int dgt = num / d;
-		num%= d;
-		d/=base;
-		if (n || dgt>0 || d==0) {
-			*bf++ = dgt+(dgt<10 ? '0' : (uc ? 'A' : 'a')-10);
-			++n;
-			}
-		}
-	*bf=0;
-	}
-
-static void i2a (int num, char * bf)
-	{
-	if (num<0) {
-		num=-num;
-		*bf++ = '-';
-		}
-	ui2a(num,10,0,bf);
-	}
-
 static int a2d(char ch)
 	{
 	if (ch>='0' && ch<='9') 
@@ -172,7 +146,7 @@ void tfp_format(void* putp,putcf putf,char *fmt, va_list va)
 						uli2a(va_arg(va, unsigned long int),10,0,bf);
 					else
 #endif
-					ui2a(va_arg(va, unsigned int),10,0,bf);
+					uitoa(va_arg(va, unsigned int),10,0,0,0,bf);
 					putchw(putp,putf,w,lz,bf);
 					break;
 					}
@@ -182,7 +156,7 @@ void tfp_format(void* putp,putcf putf,char *fmt, va_list va)
 						li2a(va_arg(va, unsigned long int),bf);
 					else
 #endif
-					i2a(va_arg(va, int),bf);
+					itoa(va_arg(va, int),bf);
 					putchw(putp,putf,w,lz,bf);
 					break;
 					}
@@ -192,7 +166,7 @@ void tfp_format(void* putp,putcf putf,char *fmt, va_list va)
 						uli2a(va_arg(va, unsigned long int),16,(ch=='X'),bf);
 					else
 #endif
-					ui2a(va_arg(va, unsigned int),16,(ch=='X'),bf);
+					uitoa(va_arg(va, unsigned int),16,(ch=='X'),0,0,bf);
 					putchw(putp,putf,w,lz,bf);
 					break;
 				case 'c' : 
@@ -241,3 +215,30 @@ void tfp_sprintf(char* s,char *fmt, ...)
 	putcp(&s,0);
 	va_end(va);
 	}
+
+struct bounded_buf
+	{
+	char* s;
+	int room;
+	};
+
+static void putcb(void* p,char c)
+	{
+	struct bounded_buf* b=(struct bounded_buf*)p;
+	if (b->room>1) {
+		*(b->s)++ = c;
+		b->room--;
+		}
+	}
+
+int tfp_vsnprintf(char* s,int size,char *fmt, va_list va)
+	{
+	struct bounded_buf b;
+	if (size<1)
+		return 0;
+	b.s=s;
+	b.room=size;
+	tfp_format(&b,putcb,fmt,va);
+	*b.s=0;
+	return size-b.room;
+	}
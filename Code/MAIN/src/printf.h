@@ -112,6 +112,7 @@ void init_printf(void* putp,void (*putf) (void*,char));
 
 void tfp_printf(char *fmt, ...);
 void tfp_sprintf(char* s,char *fmt, ...);
+int tfp_vsnprintf(char* s,int size,char *fmt, va_list va); /* writes at most size-1 chars and a 0, returns the chars written */
 
 void tfp_format(void* putp,void (*putf) (void*,char),char *fmt, va_list va);
 
@@ -74,6 +74,34 @@ QNode* pop(PriorityQueue* pqueue)
 	return NULL;
 }
 
+QNode* pop_all(PriorityQueue* pqueue)
+{
+	int i;
+	Queue* queue;
+	QNode* first = NULL;
+	QNode* last = NULL;
+	
+	assert(pqueue != NULL);
+	
+	//Link the queues together by priority (0 is highest) and empty each of them
+	for (i = 0; i < NUM_PRIORITIES; i++) {
+		queue = &(pqueue->queues[i]);
+		if (q_empty(queue)) {
+			continue;
+		}
+		if (first == NULL) {
+			first = queue->first;
+		}
+		else {
+			last->next = queue->first;
+		}
+		last = queue->last;
+		queue->first = queue->last = NULL;
+	}
+	
+	return first;
+}
+
 void push(PriorityQueue* pqueue, QNode* node, int priority)
 {
 	assert(pqueue != NULL && priority < NUM_PRIORITIES);
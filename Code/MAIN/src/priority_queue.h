@@ -50,6 +50,14 @@ QNode* top(PriorityQueue* pqueue);
  */
 QNode* pop(PriorityQueue* pqueue);
 
+/**
+ * @brief: Removes every node from the queue
+ * @return: QNode pointer to the first node, with the rest of the nodes linked after it
+ *          in the order they would have been popped
+ *          NULL if the queue is empty
+ */
+QNode* pop_all(PriorityQueue* pqueue);
+
 /**
  * @brief: Adds the input node to the end of the queue with the given priority
  */
@@ -0,0 +1,87 @@
+/**
+ * @file:   ring_buffer.c
+ * @brief:  Ring Buffer C file
+ */
+
+#ifndef DEBUG_0
+#define NDEBUG //Disable assertions
+#endif
+
+#include <assert.h>
+#include <stddef.h>
+#include "ring_buffer.h"
+
+
+void init_rb(RingBuffer* rb, char* data, int size)
+{
+	assert(rb != NULL && data != NULL && size > 0);
+	rb->data = data;
+	rb->size = size;
+	rb->head = 0;
+	rb->count = 0;
+}
+
+int rb_empty(RingBuffer* rb)
+{
+	assert(rb != NULL);
+	return rb->count == 0;
+}
+
+int rb_full(RingBuffer* rb)
+{
+	assert(rb != NULL);
+	return rb->count == rb->size;
+}
+
+int rb_space(RingBuffer* rb)
+{
+	assert(rb != NULL);
+	return rb->size - rb->count;
+}
+
+int rb_write(RingBuffer* rb, const char* src, int len)
+{
+	int tail;
+	int i;
+	assert(rb != NULL);
+	
+	//Only write as many bytes as there is room for
+	if (len > rb->size - rb->count) {
+		len = rb->size - rb->count;
+	}
+	
+	tail = rb->head + rb->count;
+	if (tail >= rb->size) {
+		tail -= rb->size;
+	}
+	for (i = 0; i < len; i++) {
+		rb->data[tail] = src[i];
+		if (++tail == rb->size) {
+			tail = 0;
+		}
+	}
+	rb->count += len;
+	
+	return len;
+}
+
+int rb_read(RingBuffer* rb, char* dest, int len)
+{
+	int i;
+	assert(rb != NULL);
+	
+	//Only read as many bytes as there are in the buffer
+	if (len > rb->count) {
+		len = rb->count;
+	}
+	
+	for (i = 0; i < len; i++) {
+		dest[i] = rb->data[rb->head];
+		if (++rb->head == rb->size) {
+			rb->head = 0;
+		}
+	}
+	rb->count -= len;
+	
+	return len;
+}
@@ -0,0 +1,27 @@
+/**
+ * @file:   ring_buffer.h
+ * @brief:  Ring Buffer header file
+ *
+ * NOTE:
+ * The ring buffer does not own its storage. The caller passes in an array that
+ * the ring buffer uses to hold up to size bytes.
+ */
+
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+typedef struct ring_buffer {
+	char* data;	/* storage for the bytes in the buffer */
+	int size;	/* number of bytes the storage can hold */
+	int head;	/* index of the next byte to get */
+	int count;	/* number of bytes in the buffer */
+} RingBuffer;
+
+void init_rb(RingBuffer* rb, char* data, int size);	// Initializes the given RingBuffer to use the given storage
+int rb_empty(RingBuffer* rb);						// Returns 1 if the ring buffer is empty; else returns 0
+int rb_full(RingBuffer* rb);						// Returns 1 if the ring buffer is full; else returns 0
+int rb_space(RingBuffer* rb);						// Returns the number of bytes that can still be added
+int rb_write(RingBuffer* rb, const char* src, int len);	// Adds up to len bytes to the end of the buffer and returns the number added
+int rb_read(RingBuffer* rb, char* dest, int len);		// Removes up to len bytes from the front of the buffer and returns the number removed
+
+#endif
@@ -13,6 +13,10 @@
 #define NUM_STRESS_PROCS 3
 
 #define USR_SZ_STACK 0x12C  /* user proc stack size 300 B */
+#define SZ_BULK_BUFFER 0x200     /* bulk buffer size is 512 B */
+#define SZ_PORT_NAME 8           /* port name size, including the null terminator */
+#define SZ_PIPE 0x80             /* pipe capacity is 128 B */
+#define SZ_MTEXT 0x6C            /* room for the body of a message in a memory block is 108 B */
 
 /* Process Priority. The bigger the number is, the lower the priority is*/
 #define HIGH    0
@@ -42,10 +46,23 @@
 #define DEFAULT 0
 #define KCD_REG 1
 #define CRT_DISPLAY 2
+#define COUNT_REPORT 5
+
+/* Message Priorities. Messages with a higher priority (lower number) are received first */
+#define MSG_PRIORITY_DEFAULT MEDIUM
+
+/* Mailbox Modes */
+#define MAILBOX_BLOCKING    0 /* senders block while the mailbox is full (sends to your own full mailbox fail) */
+#define MAILBOX_NONBLOCKING 1 /* sends to a full mailbox fail with RTX_ERR */
+
+/* Pipe Modes */
+#define PIPE_BLOCKING    0 /* wait until the whole write fits / until there is something to read */
+#define PIPE_NONBLOCKING 1 /* write or read as much as possible right now */
 
 /* ----- Types ----- */
 typedef unsigned char U8;
 typedef unsigned int U32;
+typedef unsigned long long U64;
 
 /* initialization table item */
 typedef struct proc_init
@@ -63,6 +80,13 @@ typedef struct msgbuf
 	char mtext[1];          /* body of the message */
 } MSG_BUF;
 
+/* bulk buffer descriptor, stored in the mtext of a message carrying a bulk buffer */
+typedef struct bulk_desc
+{
+	void* data;             /* start of the bulk buffer's data */
+	int length;             /* number of bytes of data in use */
+} BULK_DESC;
+
 /* ----- RTX User API ----- */
 #define __SVC_0  __svc_indirect(0)
 
@@ -95,17 +119,138 @@ extern int k_release_memory_block(void *);
 #define release_memory_block(p_mem_blk) _release_memory_block((U32)k_release_memory_block, p_mem_blk)
 extern int _release_memory_block(U32 p_func, void *p_mem_blk) __SVC_0;
 
+extern void *k_request_bulk_buffer(void);
+#define request_bulk_buffer() _request_bulk_buffer((U32)k_request_bulk_buffer)
+extern void *_request_bulk_buffer(U32 p_func) __SVC_0;
+
+extern int k_release_bulk_buffer(void *p_buf);
+#define release_bulk_buffer(p_buf) _release_bulk_buffer((U32)k_release_bulk_buffer, p_buf)
+extern int _release_bulk_buffer(U32 p_func, void *p_buf) __SVC_0;
+
+extern int k_attach_bulk_buffer(void *p_msg, void *p_buf, int length);
+#define attach_bulk_buffer(p_msg, p_buf, length) _attach_bulk_buffer((U32)k_attach_bulk_buffer, p_msg, p_buf, length)
+extern int _attach_bulk_buffer(U32 p_func, void *p_msg, void *p_buf, int length) __SVC_0;
+
 /* IPC Management */
 extern int k_send_message(int pid, void *p_msg);
 #define send_message(pid, p_msg) _send_message((U32)k_send_message, pid, p_msg)
 extern int _send_message(U32 p_func, int pid, void *p_msg) __SVC_0;
 
+extern int k_send_message_batch(int *pids, void **p_msgs, int num_msgs);
+#define send_message_batch(pids, p_msgs, num_msgs) _send_message_batch((U32)k_send_message_batch, pids, p_msgs, num_msgs)
+extern int _send_message_batch(U32 p_func, int *pids, void **p_msgs, int num_msgs) __SVC_0;
+
 extern void *k_receive_message(int *p_pid);
 #define receive_message(p_pid) _receive_message((U32)k_receive_message, p_pid)
 extern void *_receive_message(U32 p_func, void *p_pid) __SVC_0;
 
+extern void *k_receive_all_messages(int *p_pid);
+#define receive_all_messages(p_pid) _receive_all_messages((U32)k_receive_all_messages, p_pid)
+extern void *_receive_all_messages(U32 p_func, void *p_pid) __SVC_0;
+
+extern void *next_message(void *p_msg, int *p_pid); /* walks a receive_all_messages chain, not an SVC */
+
+extern int k_set_message_priority(void *p_msg, int priority);
+#define set_message_priority(p_msg, priority) _set_message_priority((U32)k_set_message_priority, p_msg, priority)
+extern int _set_message_priority(U32 p_func, void *p_msg, int priority) __SVC_0;
+
+extern int k_set_mailbox_limit(int pid, int limit, int mode);
+#define set_mailbox_limit(pid, limit, mode) _set_mailbox_limit((U32)k_set_mailbox_limit, pid, limit, mode)
+extern int _set_mailbox_limit(U32 p_func, int pid, int limit, int mode) __SVC_0;
+
+/* Synchronization */
+extern int k_set_event_flags(int pid, U32 flags);
+#define set_event_flags(pid, flags) _set_event_flags((U32)k_set_event_flags, pid, flags)
+extern int _set_event_flags(U32 p_func, int pid, U32 flags) __SVC_0;
+
+extern U32 k_wait_event_flags(U32 mask);
+#define wait_event_flags(mask) _wait_event_flags((U32)k_wait_event_flags, mask)
+extern U32 _wait_event_flags(U32 p_func, U32 mask) __SVC_0;
+
+extern int k_create_semaphore(int count);
+#define create_semaphore(count) _create_semaphore((U32)k_create_semaphore, count)
+extern int _create_semaphore(U32 p_func, int count) __SVC_0;
+
+extern int k_wait_semaphore(int sem_id);
+#define wait_semaphore(sem_id) _wait_semaphore((U32)k_wait_semaphore, sem_id)
+extern int _wait_semaphore(U32 p_func, int sem_id) __SVC_0;
+
+extern int k_signal_semaphore(int sem_id);
+#define signal_semaphore(sem_id) _signal_semaphore((U32)k_signal_semaphore, sem_id)
+extern int _signal_semaphore(U32 p_func, int sem_id) __SVC_0;
+
+extern int k_create_mutex(void);
+#define create_mutex() _create_mutex((U32)k_create_mutex)
+extern int _create_mutex(U32 p_func) __SVC_0;
+
+extern int k_lock_mutex(int mutex_id);
+#define lock_mutex(mutex_id) _lock_mutex((U32)k_lock_mutex, mutex_id)
+extern int _lock_mutex(U32 p_func, int mutex_id) __SVC_0;
+
+extern int k_unlock_mutex(int mutex_id);
+#define unlock_mutex(mutex_id) _unlock_mutex((U32)k_unlock_mutex, mutex_id)
+extern int _unlock_mutex(U32 p_func, int mutex_id) __SVC_0;
+
+/* Name Service */
+extern int k_bind_port(const char *name);
+#define bind_port(name) _bind_port((U32)k_bind_port, name)
+extern int _bind_port(U32 p_func, const char *name) __SVC_0;
+
+extern int k_lookup_port(const char *name);
+#define lookup_port(name) _lookup_port((U32)k_lookup_port, name)
+extern int _lookup_port(U32 p_func, const char *name) __SVC_0;
+
+extern int k_send_to_port(int port_id, void *p_msg);
+#define send_to_port(port_id, p_msg) _send_to_port((U32)k_send_to_port, port_id, p_msg)
+extern int _send_to_port(U32 p_func, int port_id, void *p_msg) __SVC_0;
+
+/* Pipes */
+extern int k_create_pipe(void);
+#define create_pipe() _create_pipe((U32)k_create_pipe)
+extern int _create_pipe(U32 p_func) __SVC_0;
+
+extern int k_pipe_write(int pipe_id, const char *buf, int len, int mode);
+#define pipe_write(pipe_id, buf, len, mode) _pipe_write((U32)k_pipe_write, pipe_id, buf, len, mode)
+extern int _pipe_write(U32 p_func, int pipe_id, const char *buf, int len, int mode) __SVC_0;
+
+extern int k_pipe_read(int pipe_id, char *buf, int len, int mode);
+#define pipe_read(pipe_id, buf, len, mode) _pipe_read((U32)k_pipe_read, pipe_id, buf, len, mode)
+extern int _pipe_read(U32 p_func, int pipe_id, char *buf, int len, int mode) __SVC_0;
+
 /* Timing Service */
 extern int k_delayed_send(int pid, void *p_msg, int delay);
 #define delayed_send(pid, p_msg, delay) _delayed_send((U32)k_delayed_send, pid, p_msg, delay)
-extern int _delayed_send(U32 p_func, int pid, void *p_msg, int delay) __SVC_0;  
+extern int _delayed_send(U32 p_func, int pid, void *p_msg, int delay) __SVC_0;
+
+extern int k_delayed_send_slack(int pid, void *p_msg, int delay, int slack);
+#define delayed_send_slack(pid, p_msg, delay, slack) _delayed_send_slack((U32)k_delayed_send_slack, pid, p_msg, delay, slack)
+extern int _delayed_send_slack(U32 p_func, int pid, void *p_msg, int delay, int slack) __SVC_0;
+
+extern int k_cancel_delayed_send(int timer_id);
+#define cancel_delayed_send(timer_id) _cancel_delayed_send((U32)k_cancel_delayed_send, timer_id)
+extern int _cancel_delayed_send(U32 p_func, int timer_id) __SVC_0;
+
+extern int k_reschedule_delayed_send(int timer_id, int delay);
+#define reschedule_delayed_send(timer_id, delay) _reschedule_delayed_send((U32)k_reschedule_delayed_send, timer_id, delay)
+extern int _reschedule_delayed_send(U32 p_func, int timer_id, int delay) __SVC_0;
+
+extern int k_start_periodic_timer(int pid, void *p_msg, int period);
+#define start_periodic_timer(pid, p_msg, period) _start_periodic_timer((U32)k_start_periodic_timer, pid, p_msg, period)
+extern int _start_periodic_timer(U32 p_func, int pid, void *p_msg, int period) __SVC_0;
+
+extern int k_start_periodic_timer_slack(int pid, void *p_msg, int period, int slack);
+#define start_periodic_timer_slack(pid, p_msg, period, slack) _start_periodic_timer_slack((U32)k_start_periodic_timer_slack, pid, p_msg, period, slack)
+extern int _start_periodic_timer_slack(U32 p_func, int pid, void *p_msg, int period, int slack) __SVC_0;
+
+extern int k_stop_periodic_timer(int timer_id);
+#define stop_periodic_timer(timer_id) _stop_periodic_timer((U32)k_stop_periodic_timer, timer_id)
+extern int _stop_periodic_timer(U32 p_func, int timer_id) __SVC_0;
+
+extern int k_sleep(int delay);
+#define sleep(delay) _sleep((U32)k_sleep, delay)
+extern int _sleep(U32 p_func, int delay) __SVC_0;
+
+extern int k_get_time_us(U64 *p_time);
+#define get_time_us(p_time) _get_time_us((U32)k_get_time_us, p_time)
+extern int _get_time_us(U32 p_func, U64 *p_time) __SVC_0;  
 #endif /* !RTX_H_ */
@@ -4,11 +4,10 @@
  * @date: 2014/02/28
  */
 
-#include <LPC17xx.h>
-#include "uart.h"
 #include "k_rtx.h"
 #include "sys_proc.h"
 #include "string.h"
+#include "utils.h"
 
 // KCD command structure
 typedef struct cmd {
@@ -47,112 +46,141 @@ int get_command_proc_id(const char input_line[50])
 	return RTX_ERR;
 }
 
-void KCD(void)
+/**
+ * Forwards a command line to the process that registered its command
+ * @returns 1 if the message was forwarded, 0 if the line wasn't a registered command
+ *          (in which case the caller still owns the message)
+ */
+int kcd_forward_command(MSG_BUF* command_line)
 {
-	MSG_BUF* message_received;
-	MSG_BUF* message_to_send;
-	char str_user_input[50] = "";
-	int idx_user_input = 0;
-	int command_line_received = 0;
-	int sender_id;
+	// Retreive the id of the process that registered the command
+	int reg_id = get_command_proc_id(command_line->mtext);
+	if (reg_id == RTX_ERR) {
+		return 0;
+	}
 	
-	while (1) {
-		// Receive a message
-		message_received = (MSG_BUF*)receive_message(&sender_id);
-		
-		if (message_received->mtype == KCD_REG) { // Register a command with KCD
-			if (message_received->mtext[0] != '%' || message_received->mtext[1] == '\0') {
-				message_to_send = (MSG_BUF*)request_memory_block();
-				message_to_send->mtype = CRT_DISPLAY;
-				strcpy(message_to_send->mtext, "ERROR: Commands must begin with the %% character, followed by at least one letter.\n\r");
-				send_message(PID_CRT, message_to_send);
-			}
-			else {
-				int i = 1;
-				while (message_received->mtext[i] != '\0') {
-					registered_commands[num_reg_commands].cmd_id[i - 1] = message_received->mtext[i];
-					i++;
-				}
-				registered_commands[num_reg_commands].cmd_id[i - 1] = '\0';    // Null-terminate the id
-				registered_commands[num_reg_commands].reg_proc_id = sender_id; // Set the registered proc id
-				num_reg_commands++; // Increment the number of registered commands
-			}
+	// The line was a valid command and we have retreived the id of the process registered for that command
+	// Commands are delivered ahead of any data messages waiting for the registered process
+	command_line->mtype = COMMAND;
+	set_message_priority(command_line, HIGH);
+	send_message(reg_id, command_line); // Forward the message to the registered process
+	return 1;
+}
+
+/**
+ * Sends a frame with the given payload to the CRT, for a machine client on UART0
+ * @returns RTX_OK if the frame was sent to the CRT, RTX_ERR otherwise
+ */
+int kcd_send_frame(const char* payload)
+{
+	int length = strlen(payload);
+	if (length > SZ_FRAME_PAYLOAD) {
+		return RTX_ERR;
+	}
+	return crt_printf("%c%c%s", FRAME_SOF, length, payload);
+}
+
+/**
+ * Handles a single message received by the KCD
+ */
+void kcd_handle_message(MSG_BUF* message_received, int sender_id)
+{
+	if (message_received->mtype == KCD_REG) { // Register a command with KCD
+		if (message_received->mtext[0] != '%' || message_received->mtext[1] == '\0') {
+			crt_printf("ERROR: Commands must begin with the %% character, followed by at least one letter.\n\r");
 		}
-		else if (message_received->mtype == USER_INPUT) { // User input a character
-			// Build message to send to CRT to output the input character
-			message_to_send = (MSG_BUF*)request_memory_block();
-			message_to_send->mtype = CRT_DISPLAY;
-			message_to_send->mtext[0] = message_received->mtext[0];
-			
-			if (message_received->mtext[0] == '\r') { // The user pressed ENTER
-				message_to_send->mtext[1] = '\n';
-				message_to_send->mtext[2] = '\0';
-				
-				// A full command line has been received, so put the input string into the received message's text
-				// and set the flag so that it may be forwarded
-				strcpy(message_received->mtext, str_user_input);
-				command_line_received = 1;
-				
-				// Reset the user input string and input string index
-				str_user_input[0] = '\0';
-				idx_user_input = 0;
-			}
-			else {
-				message_to_send->mtext[1] = '\0';
-				
-				if (message_received->mtext[0] == '\b' || message_received->mtext[0] == 127) { // The user pressed BACKSPACE
-					if (idx_user_input > 0) {
-						// Subtract a character from the user input string
-						str_user_input[--idx_user_input] = '\0';
-					}
-				}
-				else {
-					// Add the character to the user input string
-					str_user_input[idx_user_input] = message_received->mtext[0];
-					str_user_input[++idx_user_input] = '\0';
-				}
+		else {
+			int i = 1;
+			while (message_received->mtext[i] != '\0') {
+				registered_commands[num_reg_commands].cmd_id[i - 1] = message_received->mtext[i];
+				i++;
 			}
-			
-			send_message(PID_CRT, message_to_send); // Send message to CRT
+			registered_commands[num_reg_commands].cmd_id[i - 1] = '\0';    // Null-terminate the id
+			registered_commands[num_reg_commands].reg_proc_id = sender_id; // Set the registered proc id
+			num_reg_commands++; // Increment the number of registered commands
 		}
-		else { // We have received a normal message from a test process that contains a command line
-			command_line_received = 1;
+	}
+	else if (message_received->mtype == FRAMED_INPUT) { // A command frame from a machine client on UART0
+		// Answer with a frame saying whether the command was dispatched; its output still goes to the CRT
+		if (kcd_forward_command(message_received)) {
+			kcd_send_frame(FRAME_REPLY_OK);
+			return;
 		}
-		
-		if (command_line_received) { // We have received a full command line and its text is located in message_received->mtext
-			// Retreive the id of the process that registered the command
-			int reg_id = get_command_proc_id(message_received->mtext);
-			command_line_received = 0; // Reset the flag
-			if (reg_id != RTX_ERR) {
-				// The line was a valid command and we have retreived the id of the process registered for that command
-				message_received->mtype = COMMAND;
-				send_message(reg_id, message_received); // Forward the message to the registered process
-				continue; // Go back to the start of the loop (so that we don't release the memory of the forwarded message)
-			}
+		kcd_send_frame(FRAME_REPLY_ERR);
+	}
+	else { // A line the user typed (from the UART i-proc) or a command line from a test process
+		if (kcd_forward_command(message_received)) {
+			return; // Return now so that we don't release the memory of the forwarded message
+		}
+	}
+	
+	release_memory_block(message_received);
+}
+
+void KCD(void)
+{
+	MSG_BUF* message_received;
+	MSG_BUF* message_next;
+	int sender_id;
+	int next_sender_id;
+	
+	while (1) {
+		// Receive every pending message with one call and handle them in order
+		message_received = (MSG_BUF*)receive_all_messages(&sender_id);
+		while (message_received != NULL) {
+			// Get the next message first since handling this one will release or forward it
+			message_next = (MSG_BUF*)next_message(message_received, &next_sender_id);
+			kcd_handle_message(message_received, sender_id);
+			message_received = message_next;
+			sender_id = next_sender_id;
 		}
-		
-		release_memory_block(message_received);
 	}
 }
 
 /**
- * @brief Prints CRT_DISPLAY message to UART0 by sending message to UART i-proc and toggling interrupt bit
+ * @brief Prints CRT_DISPLAY messages to UART0 by sending them to the UART i-proc.
+ *        Display messages that are waiting together are appended into as few messages as
+ *        possible, and the kernel starts the transmission when they are delivered.
  */
 void CRT(void)
 {
 	MSG_BUF* received_message;
-	LPC_UART_TypeDef* pUart = (LPC_UART_TypeDef*) LPC_UART0;
+	MSG_BUF* next_received_message;
+	MSG_BUF* output;   // Display message the following ones are appended to
+	int output_length; // Length of the text in output
+	int length;
 	
 	while (1) {
-		// grab the message from the CRT proc message queue
-		received_message = (MSG_BUF*)receive_message((int*)0);
-		if (received_message->mtype == CRT_DISPLAY) {
-			send_message(PID_UART_IPROC, received_message);
-			// trigger the UART THRE interrupt bit so that UART i-proc runs
-			pUart->IER ^= IER_THRE;
+		// grab every message from the CRT proc message queue
+		received_message = (MSG_BUF*)receive_all_messages((int*)0);
+		output = NULL;
+		output_length = 0;
+		while (received_message != NULL) {
+			next_received_message = (MSG_BUF*)next_message(received_message, (int*)0);
+			if (received_message->mtype != CRT_DISPLAY) {
+				release_memory_block(received_message);
+			}
+			else {
+				length = strlen(received_message->mtext);
+				if (output != NULL && output_length + length < SZ_MTEXT) {
+					// Append the text to the output so far and give back the message it came in
+					strcpy(output->mtext + output_length, received_message->mtext);
+					output_length += length;
+					release_memory_block(received_message);
+				}
+				else {
+					if (output != NULL) {
+						send_message(PID_UART_IPROC, output);
+					}
+					output = received_message;
+					output_length = length;
+				}
+			}
+			received_message = next_received_message;
 		}
-		else {
-			release_memory_block(received_message);
+		
+		if (output != NULL) {
+			send_message(PID_UART_IPROC, output);
 		}
 	}
 }
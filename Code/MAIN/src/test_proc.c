@@ -12,10 +12,17 @@
 #define ONE_SECOND 1000
 #endif
 
+#define NUM_BENCH_BATCH 4 /* number of count reports per batch in the batched send benchmark, as proc_a sends them */
+#define NUM_BENCH_PIPE 16 /* number of bytes moved per iteration of the pipe benchmark */
+#define NUM_BULK_TEST_BYTES 16 /* number of bytes of the bulk buffer used by the bulk buffer test */
+#define SYNC_FLAG_A 0x1 /* event flags used by the synchronization test */
+#define SYNC_FLAG_B 0x2
+#define SYNC_FLAG_C 0x4
+
 #include <LPC17xx.h>
 #include "uart.h"
 #include "rtx.h"
-#include "uart_polling.h"
+#include "uart_log.h"
 #include "test_proc.h"
 #include "utils.h"
 #include "string.h"
@@ -65,6 +72,17 @@ int delayed_messaging_tests_pass = 0;
 int priority_command_tests_pass = 0;
 int priority_command_tests_done = 0;
 int priority_command_check_1 = 0;
+int inversion_mutex = RTX_ERR;
+int inversion_medium_ran = 0;
+int priority_inversion_tests_pass = 0;
+char* bulk_buffer_for_test = NULL;
+int bulk_buffer_tests_pass = 0;
+int sync_semaphore = RTX_ERR;
+int sync_semaphore_woken = 0;
+int sync_flags_woken = 0;
+int sync_tests_pass = 0;
+int timer_handle_tests_pass = 0;
+int slack_timer_tests_pass = 0;
 int num_tests_failed = 0;
 
 /**
@@ -79,7 +97,9 @@ void user_test_runner(void)
 	MSG_BUF* message_from_PID4;
 	MSG_BUF* message_from_PID5;
 	MSG_BUF* message_from_PID6;
+	MSG_BUF* message_from_inversion;
 	int sender_id;
+	char test_count[12];
 	
 	/* ===================================================
 	 * ================= Begin Benchmark =================
@@ -87,48 +107,139 @@ void user_test_runner(void)
 	 */
 	const int NUM_LOOPS = 1000000;
 	int loops = NUM_LOOPS;
-	uint32_t startTime, endTime;
+	int i;
+	U64 startTime, endTime; // microseconds, from get_time_us
 	uint32_t t_send_message = 0;
 	uint32_t t_receive_message = 0;
 	uint32_t t_request_memory = 0;
+	uint32_t t_send_individually = 0;
+	uint32_t t_send_batch = 0;
 	MSG_BUF* message_for_bench;
 	void* memblk_for_bench;
-	
-	NVIC_EnableIRQ(TIMER1_IRQn);
+	int pids_for_bench[NUM_BENCH_BATCH];
+	void* batch_for_bench[NUM_BENCH_BATCH];
+	uint32_t t_bytes_messages = 0;
+	uint32_t t_bytes_pipe = 0;
+	int pipe_for_bench;
+	char bytes_for_bench[NUM_BENCH_PIPE];
+	uint32_t t_itoa = 0;
+	char itoa_for_bench[12];
+	
+	// Time with the microsecond clock, and keep the 1 ms benchmark timer's interrupt out of the timed sections
+	NVIC_DisableIRQ(TIMER1_IRQn);
 	
 	while (loops--) {
 		/* Request memory block */
-		startTime = get_current_bench_time();
+		get_time_us(&startTime);
 		memblk_for_bench = request_memory_block();
-		endTime = get_current_bench_time();
+		get_time_us(&endTime);
 		t_request_memory += endTime - startTime;
 		
 		/* Send message */
 		message_for_bench = (MSG_BUF*)memblk_for_bench;
 		message_for_bench->mtype = DEFAULT;
-		startTime = get_current_bench_time();
+		get_time_us(&startTime);
 		send_message(PID_P1, message_for_bench); // Send message to self
-		endTime = get_current_bench_time();
+		get_time_us(&endTime);
 		t_send_message += endTime - startTime;
 		
 		/* Receive mmessage */
-		startTime = get_current_bench_time();
+		get_time_us(&startTime);
 		message_for_bench = (MSG_BUF*)receive_message(0);
-		endTime = get_current_bench_time();
+		get_time_us(&endTime);
 		t_receive_message += endTime - startTime;
 		
 		/* Cleanup */
 		release_memory_block(message_for_bench);
 	}
 	
-	NVIC_DisableIRQ(TIMER1_IRQn);
+	/* Send proc_a's count reports to proc_b one SVC at a time and then as one batch, like proc_a does.
+	 * proc_b and proc_c are HIGH priority, so each timed send includes passing the reports down the
+	 * proc_b -> proc_c pipeline until proc_c releases them. Every batch holds the counts 0 to 3,
+	 * since proc_c hibernates for 10 s on counts like 20. */
+	for (i = 0; i < NUM_BENCH_BATCH; i++) {
+		pids_for_bench[i] = PID_B;
+	}
+	loops = NUM_LOOPS / NUM_BENCH_BATCH;
+	while (loops--) {
+		/* Send count reports individually */
+		for (i = 0; i < NUM_BENCH_BATCH; i++) {
+			message_for_bench = (MSG_BUF*)request_memory_block();
+			message_for_bench->mtype = COUNT_REPORT;
+			itoa(i, message_for_bench->mtext);
+			batch_for_bench[i] = message_for_bench;
+		}
+		get_time_us(&startTime);
+		for (i = 0; i < NUM_BENCH_BATCH; i++) {
+			send_message(PID_B, batch_for_bench[i]);
+		}
+		get_time_us(&endTime);
+		t_send_individually += endTime - startTime;
+		
+		/* Send count reports as a batch */
+		for (i = 0; i < NUM_BENCH_BATCH; i++) {
+			message_for_bench = (MSG_BUF*)request_memory_block();
+			message_for_bench->mtype = COUNT_REPORT;
+			itoa(i, message_for_bench->mtext);
+			batch_for_bench[i] = message_for_bench;
+		}
+		get_time_us(&startTime);
+		send_message_batch(pids_for_bench, batch_for_bench, NUM_BENCH_BATCH);
+		get_time_us(&endTime);
+		t_send_batch += endTime - startTime;
+	}
 	
-	/* Output stats */
-	__disable_irq();
-	printf("Time for %d iterations of request_memory_block = %u\r\n", NUM_LOOPS, t_request_memory);
-	printf("Time for %d iterations of send_message = %u\r\n", NUM_LOOPS, t_send_message);
-	printf("Time for %d iterations of receive_message = %u\r\n", NUM_LOOPS, t_receive_message);
-	__enable_irq();
+	/* Move bytes to self with one message per byte and then through a pipe. Nothing in the system
+	 * moves bytes through a pipe any more, so this only compares the two mechanisms. */
+	pipe_for_bench = create_pipe();
+	for (i = 0; i < NUM_BENCH_PIPE; i++) {
+		bytes_for_bench[i] = 'a' + i;
+	}
+	loops = NUM_LOOPS / NUM_BENCH_PIPE;
+	while (loops--) {
+		/* One message per byte */
+		get_time_us(&startTime);
+		for (i = 0; i < NUM_BENCH_PIPE; i++) {
+			message_for_bench = (MSG_BUF*)request_memory_block();
+			message_for_bench->mtype = DEFAULT;
+			message_for_bench->mtext[0] = bytes_for_bench[i];
+			send_message(PID_P1, message_for_bench);
+		}
+		for (i = 0; i < NUM_BENCH_PIPE; i++) {
+			message_for_bench = (MSG_BUF*)receive_message(0);
+			bytes_for_bench[i] = message_for_bench->mtext[0];
+			release_memory_block(message_for_bench);
+		}
+		get_time_us(&endTime);
+		t_bytes_messages += endTime - startTime;
+		
+		/* Every byte through the pipe at once */
+		get_time_us(&startTime);
+		pipe_write(pipe_for_bench, bytes_for_bench, NUM_BENCH_PIPE, PIPE_BLOCKING);
+		pipe_read(pipe_for_bench, bytes_for_bench, NUM_BENCH_PIPE, PIPE_NONBLOCKING);
+		get_time_us(&endTime);
+		t_bytes_pipe += endTime - startTime;
+	}
+	
+	/* Format integers of every length */
+	loops = NUM_LOOPS;
+	get_time_us(&startTime);
+	while (loops--) {
+		itoa(loops * 2147, itoa_for_bench);
+	}
+	get_time_us(&endTime);
+	t_itoa = endTime - startTime;
+	
+	/* Output stats. IRQs stay on so UART1 can drain the log buffer while it fills */
+	printf("Time for %d iterations of request_memory_block = %u us\r\n", NUM_LOOPS, t_request_memory);
+	printf("Time for %d iterations of send_message = %u us\r\n", NUM_LOOPS, t_send_message);
+	printf("Time for %d iterations of receive_message = %u us\r\n", NUM_LOOPS, t_receive_message);
+	printf("Time for %d count reports sent to proc_b with send_message = %u us\r\n", NUM_LOOPS, t_send_individually);
+	printf("Time for %d count reports sent to proc_b with send_message_batch = %u us\r\n", NUM_LOOPS, t_send_batch);
+	printf("Time for %d bytes sent to self as messages = %u us\r\n", NUM_LOOPS, t_bytes_messages);
+	printf("Time for %d bytes sent to self through a pipe = %u us\r\n", NUM_LOOPS, t_bytes_pipe);
+	printf("Time for %d iterations of itoa = %u us\r\n", NUM_LOOPS, t_itoa);
+	printf("Debug console bytes dropped so far = %u\r\n", log_dropped());
 	
 	/* ===================================================
 	 * ================== End Benchmark ==================
@@ -137,8 +248,8 @@ void user_test_runner(void)
 	
 	while (!done_testing) {
 		// Print introductory test strings
-		uart1_put_string("G023_test: START\r\n");
-		uart1_put_string("G023_test: Total 6 Tests\r\n");
+		log_put_string("G023_test: START\r\n");
+		log_put_string("G023_test: Total 10 Tests\r\n");
 		
 		// PID_2 ... PID_6 haven't run yet (i.e. they're not blocked yet)
 		// So let's release processor so that proc2 can actually run
@@ -154,10 +265,10 @@ void user_test_runner(void)
 		priority_tests_done = 1;
 		
 		if (priority_tests_pass) {
-			uart1_put_string("G023_test: Test 1 OK\r\n");
+			log_put_string("G023_test: Test 1 OK\r\n");
 		}
 		else {
-			uart1_put_string("G023_test: Test 1 FAIL\r\n");
+			log_put_string("G023_test: Test 1 FAIL\r\n");
 			num_tests_failed++;
 		}
 		
@@ -180,10 +291,10 @@ void user_test_runner(void)
 		release_memory_block(mem_block_to_unblock);
 		
 		if (memory_tests_pass && block_check_2) {
-			uart1_put_string("G023_test: Test 2 OK\r\n");
+			log_put_string("G023_test: Test 2 OK\r\n");
 		}
 		else {
-			uart1_put_string("G023_test: Test 2 FAIL\r\n");
+			log_put_string("G023_test: Test 2 FAIL\r\n");
 			num_tests_failed++;
 		}
 		
@@ -203,10 +314,10 @@ void user_test_runner(void)
 		release_processor();
 		
 		if (general_messaging_tests_pass) {
-			uart1_put_string("G023_test: Test 3 OK\r\n");
+			log_put_string("G023_test: Test 3 OK\r\n");
 		}
 		else {
-			uart1_put_string("G023_test: Test 3 FAIL\r\n");
+			log_put_string("G023_test: Test 3 FAIL\r\n");
 			num_tests_failed++;
 		}
 		
@@ -230,10 +341,10 @@ void user_test_runner(void)
 		send_message(PID_P5, message_to_unblock);
 		
 		if (delayed_messaging_tests_pass) {
-			uart1_put_string("G023_test: Test 4 OK\r\n");
+			log_put_string("G023_test: Test 4 OK\r\n");
 		}
 		else {
-			uart1_put_string("G023_test: Test 4 FAIL\r\n");
+			log_put_string("G023_test: Test 4 FAIL\r\n");
 			num_tests_failed++;
 		}
 		
@@ -252,24 +363,96 @@ void user_test_runner(void)
 		}
 		
 		if (priority_command_tests_pass) {
-			uart1_put_string("G023_test: Test 5 OK\r\n");
+			log_put_string("G023_test: Test 5 OK\r\n");
 		}
 		else {
-			uart1_put_string("G023_test: Test 5 FAIL\r\n");
+			log_put_string("G023_test: Test 5 FAIL\r\n");
+			num_tests_failed++;
+		}
+		
+		// Set up a priority inversion: PID_P3 (LOW) holds a mutex that PID_P5 (HIGH) needs,
+		// while PID_P4 (MEDIUM) is ready to run. They are all blocked on receive, so this doesn't pre-empt.
+		inversion_mutex = create_mutex();
+		set_process_priority(PID_P3, LOW);
+		set_process_priority(PID_P4, MEDIUM);
+		set_process_priority(PID_P5, HIGH);
+		
+		// Unblock PID_P3 so it can lock the mutex and start the other two
+		message_to_unblock = (MSG_BUF*)request_memory_block();
+		message_to_unblock->mtype = DEFAULT;
+		message_to_unblock->mtext[0] = 'U';
+		message_to_unblock->mtext[1] = '\0';
+		send_message(PID_P3, message_to_unblock);
+		
+		// Block until PID_P5 has locked and unlocked the mutex
+		message_from_inversion = (MSG_BUF*)receive_message(&sender_id);
+		release_memory_block(message_from_inversion);
+		
+		if (sender_id == PID_P5 && priority_inversion_tests_pass) {
+			log_put_string("G023_test: Test 6 OK\r\n");
+		}
+		else {
+			log_put_string("G023_test: Test 6 FAIL\r\n");
+			num_tests_failed++;
+		}
+		
+		// Send a bulk buffer to PID_P6 (LOW), which checks it once we block waiting for its result
+		bulk_buffer_send_tests();
+		message_from_PID6 = (MSG_BUF*)receive_message(&sender_id);
+		release_memory_block(message_from_PID6);
+		
+		if (sender_id == PID_P6 && bulk_buffer_tests_pass) {
+			log_put_string("G023_test: Test 7 OK\r\n");
+		}
+		else {
+			log_put_string("G023_test: Test 7 FAIL\r\n");
+			num_tests_failed++;
+		}
+		
+		// Wake PID_P5 (HIGH) with a semaphore and event flags, then collect its result
+		sync_tests_medium();
+		message_from_PID5 = (MSG_BUF*)receive_message(&sender_id);
+		release_memory_block(message_from_PID5);
+		
+		if (sender_id == PID_P5 && sync_tests_pass) {
+			log_put_string("G023_test: Test 8 OK\r\n");
+		}
+		else {
+			log_put_string("G023_test: Test 8 FAIL\r\n");
+			num_tests_failed++;
+		}
+		
+		timer_handle_tests();
+		
+		if (timer_handle_tests_pass) {
+			log_put_string("G023_test: Test 9 OK\r\n");
+		}
+		else {
+			log_put_string("G023_test: Test 9 FAIL\r\n");
+			num_tests_failed++;
+		}
+		
+		slack_timer_tests();
+		
+		if (slack_timer_tests_pass) {
+			log_put_string("G023_test: Test 10 OK\r\n");
+		}
+		else {
+			log_put_string("G023_test: Test 10 FAIL\r\n");
 			num_tests_failed++;
 		}
 		
 		// Print the total number of tests that passed
-		uart1_put_string("G023_test: ");
-		uart1_put_char('0' + 5 - num_tests_failed);
-		uart1_put_string("/5 Tests OK\r\n");
+		log_put_string("G023_test: ");
+		log_put_string(itoa(10 - num_tests_failed, test_count));
+		log_put_string("/10 Tests OK\r\n");
 		
 		// Print the total number of tests that failed
-		uart1_put_string("G023_test: ");
-		uart1_put_char('0' + num_tests_failed);
-		uart1_put_string("/5 Tests FAIL\r\n");
+		log_put_string("G023_test: ");
+		log_put_string(itoa(num_tests_failed, test_count));
+		log_put_string("/10 Tests FAIL\r\n");
 		
-		uart1_put_string("G023_test: END\r\n");
+		log_put_string("G023_test: END\r\n");
 		
 		done_testing = 1;
 
@@ -462,6 +645,13 @@ void memory_tests(void)
 		tests_passing = 0;
 	}
 	
+	// Pointers that aren't memory blocks are rejected, whether they point into a block or elsewhere
+	if (release_memory_block((U8*)mem_block_1 + 4) != RTX_ERR
+	        || set_message_priority((U8*)mem_block_1 + 4, HIGH) != RTX_ERR
+	        || set_message_priority(&tests_passing, HIGH) != RTX_ERR) {
+		tests_passing = 0;
+	}
+	
 	// For this section, we want the following to happen:
 	// Release processor so that PID_P1 can run
 	release_processor();
@@ -486,8 +676,14 @@ void memory_tests(void)
 	// If 1 -> test case passed
 	memory_tests_pass = tests_passing;
 	
+	// Request a message to block this process until the priority inversion test
+	message_to_unblock = (MSG_BUF*)receive_message((int*)0);
+	release_memory_block(message_to_unblock);
+	
+	priority_inversion_low();
+	
 	// Request a message to block this process
-	// This avoids running into PID_P2 accidentally / anytime after running the priority tests
+	// This avoids running into PID_P3 accidentally / anytime after running the priority inversion test
 	message_to_unblock = (MSG_BUF*)receive_message((int*)0);
 	
 	// Theoretically should never get here, but just to be safe...
@@ -551,8 +747,14 @@ void general_messaging_tests(void)
 	// If 1 -> test case passed
 	general_messaging_tests_pass = tests_passing;
 	
+	// Request a message to block this process until the priority inversion test
+	message_to_unblock = (MSG_BUF*)receive_message((int*)0);
+	release_memory_block(message_to_unblock);
+	
+	priority_inversion_medium();
+	
 	// Request a message to block this process
-	// This avoids running into PID_P2 accidentally / anytime after running the priority tests
+	// This avoids running into PID_P4 accidentally / anytime after running the priority inversion test
 	message_to_unblock = (MSG_BUF*)receive_message((int*)0);
 	
 	// Theoretically should never get here, but just to be safe...
@@ -620,13 +822,24 @@ void delayed_messaging_tests(void)
 	// If 1 -> test case passed
 	delayed_messaging_tests_pass = tests_passing;
 	
+	// Request a message to block this process until the priority inversion test
+	message_to_unblock = (MSG_BUF*)receive_message((int*)0);
+	release_memory_block(message_to_unblock);
+	
+	priority_inversion_high();
+	
+	// Request a message to block this process until the synchronization test
+	message_to_unblock = (MSG_BUF*)receive_message((int*)0);
+	release_memory_block(message_to_unblock);
+	
+	sync_tests_high();
+	
 	// Request a message to block this process
-	// This avoids running into PID_P5 accidentally / anytime after running the priority tests
+	// This avoids running into PID_P5 accidentally / anytime after running the synchronization test
 	message_to_unblock = (MSG_BUF*)receive_message((int*)0);
 	
 	// Theoretically should never get here, but just to be safe...
 	release_memory_block(message_to_unblock);
-	
 }
 
 /**
@@ -708,10 +921,442 @@ void set_priority_command_tests(void)
 	message_to_send->mtext[1] = '\0';
 	send_message(PID_P1, message_to_send);
 	
+	bulk_buffer_receive_tests();
+	
 	// Request a message to block this process
-	// This avoids running into PID_P6 accidentally / anytime after running the priority tests
+	// This avoids running into PID_P6 accidentally / anytime after running the bulk buffer test
 	message_to_unblock = (MSG_BUF*)receive_message((int*)0);
 	
 	// Theoretically should never get here, but just to be safe...
 	release_memory_block(message_to_unblock);
 }
+
+/**
+ * @brief: The LOW priority side of the priority inversion test (run by PID_P3).
+ * Locks the mutex, then starts PID_P5 so that it blocks on the mutex while PID_P4 is ready.
+ */
+void priority_inversion_low(void)
+{
+	MSG_BUF* message_to_send;
+	int tests_passing = 1;
+	
+	if (lock_mutex(inversion_mutex) == RTX_ERR) {
+		tests_passing = 0;
+	}
+	
+	// Locking a mutex this process already holds is an error
+	if (lock_mutex(inversion_mutex) != RTX_ERR) {
+		tests_passing = 0;
+	}
+	
+	// PID_P5 pre-empts us, unblocks PID_P4 and blocks on the mutex
+	message_to_send = (MSG_BUF*)request_memory_block();
+	message_to_send->mtype = DEFAULT;
+	message_to_send->mtext[0] = 'U';
+	message_to_send->mtext[1] = '\0';
+	send_message(PID_P5, message_to_send);
+	
+	// We should be running at PID_P5's priority now, so PID_P4 shouldn't have run yet
+	if (get_process_priority(PID_P3) != HIGH
+	        || inversion_medium_ran) {
+		tests_passing = 0;
+	}
+	
+	// Only the owner can unlock the mutex, so hand over the result before PID_P5 checks it
+	priority_inversion_tests_pass = tests_passing;
+	
+	// Unlocking hands the mutex to PID_P5, which pre-empts us
+	if (unlock_mutex(inversion_mutex) == RTX_ERR) {
+		priority_inversion_tests_pass = 0;
+	}
+}
+
+/**
+ * @brief: The MEDIUM priority side of the priority inversion test (run by PID_P4).
+ * Should only get to run once PID_P5 is done with the mutex.
+ */
+void priority_inversion_medium(void)
+{
+	inversion_medium_ran = 1;
+}
+
+/**
+ * @brief: The HIGH priority side of the priority inversion test (run by PID_P5).
+ * Blocks on the mutex held by PID_P3 and reports the result of the test to PID_P1.
+ */
+void priority_inversion_high(void)
+{
+	MSG_BUF* message_to_send;
+	int tests_passing = 1;
+	
+	// Make PID_P4 ready to run while PID_P3 still holds the mutex
+	message_to_send = (MSG_BUF*)request_memory_block();
+	message_to_send->mtype = DEFAULT;
+	message_to_send->mtext[0] = 'U';
+	message_to_send->mtext[1] = '\0';
+	send_message(PID_P4, message_to_send);
+	
+	if (lock_mutex(inversion_mutex) == RTX_ERR) {
+		tests_passing = 0;
+	}
+	
+	// PID_P3 should have finished with the mutex before PID_P4 could run,
+	// and given up the priority it inherited from us
+	if (inversion_medium_ran
+	        || get_process_priority(PID_P3) != LOW) {
+		tests_passing = 0;
+	}
+	
+	if (unlock_mutex(inversion_mutex) == RTX_ERR) {
+		tests_passing = 0;
+	}
+	
+	// Send test case result back to PID_P1
+	// If 0 -> test case failed
+	// If 1 -> test case passed
+	priority_inversion_tests_pass = priority_inversion_tests_pass && tests_passing;
+	
+	message_to_send = (MSG_BUF*)request_memory_block();
+	message_to_send->mtype = DEFAULT;
+	message_to_send->mtext[0] = 'S';
+	message_to_send->mtext[1] = '\0';
+	send_message(PID_P1, message_to_send);
+}
+
+/**
+ * @brief: The sending side of the bulk buffer test (run by PID_P1).
+ * Attaches a bulk buffer to a message and sends it to PID_P6. Once attached, the buffer
+ * can't be released or attached again, and it belongs to the message rather than to us.
+ */
+void bulk_buffer_send_tests(void)
+{
+	MSG_BUF* message_to_send;
+	MSG_BUF* second_message;
+	char* buffer;
+	int i;
+	int tests_passing = 1;
+	
+	buffer = (char*)request_bulk_buffer();
+	message_to_send = (MSG_BUF*)request_memory_block();
+	message_to_send->mtype = DEFAULT;
+	second_message = (MSG_BUF*)request_memory_block();
+	
+	if (buffer == NULL) {
+		tests_passing = 0;
+	}
+	else {
+		for (i = 0; i < NUM_BULK_TEST_BYTES; i++) {
+			buffer[i] = 'a' + i;
+		}
+	}
+	
+	if (attach_bulk_buffer(message_to_send, buffer, NUM_BULK_TEST_BYTES) == RTX_ERR) {
+		tests_passing = 0;
+	}
+	
+	// The attached buffer goes back with the message, so it can't be released or attached on its own
+	if (release_bulk_buffer(buffer) != RTX_ERR
+	        || attach_bulk_buffer(second_message, buffer, NUM_BULK_TEST_BYTES) != RTX_ERR) {
+		tests_passing = 0;
+	}
+	release_memory_block(second_message);
+	
+	// Sending the message hands the buffer over to PID_P6
+	bulk_buffer_for_test = buffer;
+	bulk_buffer_tests_pass = tests_passing;
+	send_message(PID_P6, message_to_send);
+	
+	if (release_bulk_buffer(buffer) != RTX_ERR) {
+		bulk_buffer_tests_pass = 0;
+	}
+}
+
+/**
+ * @brief: The receiving side of the bulk buffer test (run by PID_P6).
+ * Checks that the buffer arrived intact, that releasing the message returns the buffer to the pool
+ * even after the descriptor in its mtext is overwritten,
+ * and that the buffer can't be released a second time. Reports the result of the test to PID_P1.
+ */
+void bulk_buffer_receive_tests(void)
+{
+	MSG_BUF* message_received;
+	MSG_BUF* message_to_send;
+	BULK_DESC* desc;
+	char* buffer;
+	int i;
+	int sender_id;
+	int tests_passing = 1;
+	
+	message_received = (MSG_BUF*)receive_message(&sender_id);
+	desc = (BULK_DESC*)message_received->mtext;
+	buffer = (char*)desc->data;
+	
+	if (sender_id != PID_P1 || buffer != bulk_buffer_for_test || desc->length != NUM_BULK_TEST_BYTES) {
+		tests_passing = 0;
+	}
+	else {
+		for (i = 0; i < NUM_BULK_TEST_BYTES; i++) {
+			if (buffer[i] != 'a' + i) {
+				tests_passing = 0;
+			}
+		}
+	}
+	
+	// The buffer is still attached to the message, so only releasing the message gives it back.
+	// The kernel doesn't go through the descriptor to find it, so clobbering the descriptor is harmless
+	desc->data = NULL;
+	if (release_bulk_buffer(buffer) != RTX_ERR
+	        || release_memory_block(message_received) == RTX_ERR) {
+		tests_passing = 0;
+	}
+	
+	// The buffer is back in the pool: releasing it again fails, and it is the next one handed out
+	if (release_bulk_buffer(buffer) != RTX_ERR
+	        || request_bulk_buffer() != buffer) {
+		tests_passing = 0;
+	}
+	if (release_bulk_buffer(buffer) == RTX_ERR
+	        || release_bulk_buffer(buffer) != RTX_ERR) {
+		tests_passing = 0;
+	}
+	
+	// Send test case result back to PID_P1
+	// If 0 -> test case failed
+	// If 1 -> test case passed
+	bulk_buffer_tests_pass = bulk_buffer_tests_pass && tests_passing;
+	
+	message_to_send = (MSG_BUF*)request_memory_block();
+	message_to_send->mtype = DEFAULT;
+	message_to_send->mtext[0] = 'S';
+	message_to_send->mtext[1] = '\0';
+	send_message(PID_P1, message_to_send);
+}
+
+/**
+ * @brief: The MEDIUM priority side of the synchronization test (run by PID_P1).
+ * Starts PID_P5, then signals the semaphore and sets the event flags it waits on.
+ * PID_P5 is HIGH, so it pre-empts us as soon as it is woken up.
+ */
+void sync_tests_medium(void)
+{
+	MSG_BUF* message_to_send;
+	int tests_passing = 1;
+	
+	// Invalid semaphores and processes are rejected
+	sync_semaphore = create_semaphore(0);
+	if (sync_semaphore == RTX_ERR
+	        || create_semaphore(-1) != RTX_ERR
+	        || wait_semaphore(-1) != RTX_ERR
+	        || signal_semaphore(-1) != RTX_ERR
+	        || set_event_flags(-1, SYNC_FLAG_A) != RTX_ERR) {
+		tests_passing = 0;
+	}
+	
+	// PID_P5 pre-empts us and blocks on the semaphore, since its count is 0
+	message_to_send = (MSG_BUF*)request_memory_block();
+	message_to_send->mtype = DEFAULT;
+	message_to_send->mtext[0] = 'U';
+	message_to_send->mtext[1] = '\0';
+	send_message(PID_P5, message_to_send);
+	
+	if (sync_semaphore_woken) {
+		tests_passing = 0;
+	}
+	
+	// Signalling wakes PID_P5, which then blocks waiting for SYNC_FLAG_A or SYNC_FLAG_B
+	if (signal_semaphore(sync_semaphore) == RTX_ERR
+	        || !sync_semaphore_woken) {
+		tests_passing = 0;
+	}
+	
+	// A flag PID_P5 isn't waiting for doesn't wake it, but stays set for later
+	if (set_event_flags(PID_P5, SYNC_FLAG_C) == RTX_ERR
+	        || sync_flags_woken) {
+		tests_passing = 0;
+	}
+	
+	// With nobody waiting, signals are counted so PID_P5 can wait twice without blocking
+	if (signal_semaphore(sync_semaphore) == RTX_ERR
+	        || signal_semaphore(sync_semaphore) == RTX_ERR) {
+		tests_passing = 0;
+	}
+	
+	// Setting a flag PID_P5 is waiting for wakes it up, and it runs to the end of its side of the test
+	if (set_event_flags(PID_P5, SYNC_FLAG_B) == RTX_ERR
+	        || !sync_flags_woken) {
+		tests_passing = 0;
+	}
+	
+	sync_tests_pass = sync_tests_pass && tests_passing;
+}
+
+/**
+ * @brief: The HIGH priority side of the synchronization test (run by PID_P5).
+ * Blocks on the semaphore and then on event flags until PID_P1 wakes it up,
+ * and reports the result of the test to PID_P1.
+ */
+void sync_tests_high(void)
+{
+	MSG_BUF* message_to_send;
+	int tests_passing = 1;
+	
+	if (wait_semaphore(sync_semaphore) == RTX_ERR) {
+		tests_passing = 0;
+	}
+	sync_semaphore_woken = 1;
+	
+	// Only the flag that was waited for is returned (and cleared)
+	if (wait_event_flags(SYNC_FLAG_A | SYNC_FLAG_B) != SYNC_FLAG_B) {
+		tests_passing = 0;
+	}
+	sync_flags_woken = 1;
+	
+	// SYNC_FLAG_C was set while we waited for the others, so waiting for it returns right away
+	if (wait_event_flags(SYNC_FLAG_C) != SYNC_FLAG_C
+	        || wait_event_flags(0) != 0) {
+		tests_passing = 0;
+	}
+	
+	// The semaphore was signalled twice with nobody waiting, so neither of these blocks
+	if (wait_semaphore(sync_semaphore) == RTX_ERR
+	        || wait_semaphore(sync_semaphore) == RTX_ERR) {
+		tests_passing = 0;
+	}
+	
+	// Send test case result back to PID_P1
+	// If 0 -> test case failed
+	// If 1 -> test case passed
+	sync_tests_pass = tests_passing;
+	
+	message_to_send = (MSG_BUF*)request_memory_block();
+	message_to_send->mtype = DEFAULT;
+	message_to_send->mtext[0] = 'S';
+	message_to_send->mtext[1] = '\0';
+	send_message(PID_P1, message_to_send);
+}
+
+/**
+ * @brief: Tests cancelling and rescheduling delayed sends (run by PID_P1).
+ * Every message is delayed_send to ourselves, so the order they arrive in shows when they were delivered.
+ */
+void timer_handle_tests(void)
+{
+	MSG_BUF* first;
+	MSG_BUF* second;
+	int handle;
+	int tests_passing = 1;
+	
+	first = (MSG_BUF*)request_memory_block();
+	first->mtype = DEFAULT;
+	second = (MSG_BUF*)request_memory_block();
+	second->mtype = DEFAULT;
+	
+	// Cancelling before the message is delivered gives its memory block straight back to the heap
+	handle = delayed_send(PID_P1, first, ONE_SECOND);
+	if (handle == RTX_ERR
+	        || cancel_delayed_send(handle) == RTX_ERR
+	        || request_memory_block() != first) {
+		tests_passing = 0;
+	}
+	
+	// The handle of a cancelled send is stale
+	if (cancel_delayed_send(handle) != RTX_ERR
+	        || reschedule_delayed_send(handle, ONE_SECOND) != RTX_ERR) {
+		tests_passing = 0;
+	}
+	
+	// Once the message has been delivered, it can't be cancelled
+	handle = delayed_send(PID_P1, first, ONE_SECOND / 10);
+	if (receive_message((int*)0) != first
+	        || cancel_delayed_send(handle) != RTX_ERR) {
+		tests_passing = 0;
+	}
+	
+	// Rescheduling later moves the first message behind the second
+	handle = delayed_send(PID_P1, first, ONE_SECOND / 10);
+	delayed_send(PID_P1, second, 2 * ONE_SECOND / 10);
+	if (reschedule_delayed_send(handle, 3 * ONE_SECOND / 10) == RTX_ERR
+	        || receive_message((int*)0) != second
+	        || receive_message((int*)0) != first) {
+		tests_passing = 0;
+	}
+	
+	// Rescheduling sooner moves the first message ahead of the second
+	handle = delayed_send(PID_P1, first, 10 * ONE_SECOND);
+	delayed_send(PID_P1, second, 2 * ONE_SECOND / 10);
+	if (reschedule_delayed_send(handle, ONE_SECOND / 10) == RTX_ERR
+	        || receive_message((int*)0) != first
+	        || receive_message((int*)0) != second) {
+		tests_passing = 0;
+	}
+	
+	release_memory_block(first);
+	release_memory_block(second);
+	
+	timer_handle_tests_pass = tests_passing;
+}
+
+/**
+ * @brief: Tests timers with slack (run by PID_P1).
+ * Arms a delayed send and a periodic timer whose slack windows cover the expiry of a later
+ * delayed send without slack. None of them should arrive before that expiry, and then all
+ * three should be delivered in the same pass of the timer i-process.
+ */
+void slack_timer_tests(void)
+{
+	MSG_BUF* first;
+	MSG_BUF* tick;
+	MSG_BUF* last;
+	MSG_BUF* message;
+	int tick_timer;
+	int num_received = 0;
+	U64 start_time;
+	U64 end_time;
+	int tests_passing = 1;
+	
+	first = (MSG_BUF*)request_memory_block();
+	first->mtype = DEFAULT;
+	tick = (MSG_BUF*)request_memory_block();
+	tick->mtype = DEFAULT;
+	last = (MSG_BUF*)request_memory_block();
+	last->mtype = DEFAULT;
+	
+	// first may wait until 3/10 s and tick until 3/10 s, so both can go along with last at 1/4 s
+	get_time_us(&start_time);
+	tick_timer = start_periodic_timer_slack(PID_P1, tick, 2 * ONE_SECOND / 10, ONE_SECOND / 10);
+	if (delayed_send_slack(PID_P1, first, ONE_SECOND / 10, 2 * ONE_SECOND / 10) == RTX_ERR
+	        || tick_timer == RTX_ERR
+	        || delayed_send(PID_P1, last, ONE_SECOND / 4) == RTX_ERR) {
+		tests_passing = 0;
+	}
+	
+	// All three are delivered before we run again, so they are all waiting when we wake up
+	message = (MSG_BUF*)receive_all_messages((int*)0);
+	get_time_us(&end_time);
+	if (end_time - start_time < (U64)(ONE_SECOND / 4 - 1) * 1000) {
+		tests_passing = 0;
+	}
+	while (message != NULL) {
+		if (message != first && message != tick && message != last) {
+			tests_passing = 0;
+		}
+		num_received++;
+		message = (MSG_BUF*)next_message(message, (int*)0);
+	}
+	if (num_received != 3 || *(int*)tick->mtext != 1) {
+		tests_passing = 0;
+	}
+	
+	// Slack can't be negative
+	if (delayed_send_slack(PID_P1, first, ONE_SECOND, -1) != RTX_ERR) {
+		tests_passing = 0;
+	}
+	
+	// The stopped timer's notification goes back to the heap when it is released
+	stop_periodic_timer(tick_timer);
+	release_memory_block(tick);
+	release_memory_block(first);
+	release_memory_block(last);
+	
+	slack_timer_tests_pass = tests_passing;
+}
@@ -13,5 +13,14 @@ void memory_tests(void);
 void general_messaging_tests(void);
 void delayed_messaging_tests(void);
 void set_priority_command_tests(void);
+void priority_inversion_low(void);
+void priority_inversion_medium(void);
+void priority_inversion_high(void);
+void bulk_buffer_send_tests(void);
+void bulk_buffer_receive_tests(void);
+void sync_tests_medium(void);
+void sync_tests_high(void);
+void timer_handle_tests(void);
+void slack_timer_tests(void);
 
 #endif /* TEST_PROC_H_ */
@@ -0,0 +1,34 @@
+/**
+ * @file:   trace.c
+ * @brief:  Binary kernel event trace. Records are queued on the UART1 debug console
+ *          in one piece, so a full console drops whole records rather than parts of them.
+ */
+
+#include <LPC17xx.h>
+#include "trace.h"
+#include "uart_log.h"
+#include "i_proc.h"
+
+/**
+ * @brief: Queues a record of the event, stamped with the monotonic clock
+ * NOTE: Can be called from anywhere, including interrupt handlers and with interrupts disabled
+ */
+void trace_event(uint8_t event, uint8_t pid, uint8_t arg)
+{
+	TRACE_RECORD record;
+	uint32_t primask = __get_PRIMASK();
+	
+	__disable_irq(); // atomic(on)
+	
+	record.m_sync = TRACE_SYNC;
+	record.m_event = event;
+	record.m_pid = pid;
+	record.m_arg = arg;
+	record.m_time = (uint32_t)get_monotonic_time_us();
+	log_write_record((const char*)&record, sizeof(record));
+	
+	// Leave interrupts disabled if the caller had them disabled
+	if (!primask) {
+		__enable_irq(); // atomic(off)
+	}
+}
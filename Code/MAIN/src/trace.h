@@ -0,0 +1,58 @@
+/**
+ * @file:   trace.h
+ * @brief:  Binary kernel event trace streamed over the UART1 debug console
+ *
+ * NOTE:
+ * Each event is a fixed-size TRACE_RECORD. Records start with TRACE_SYNC, which is
+ * never part of the ASCII debug text sharing UART1, so tools/trace_decode.c can pick
+ * them out of a capture and render them as a timeline.
+ * Tracing is opt-in: TRACE compiles to nothing unless DEBUG_TRACE is defined. The records
+ * are binary and share UART1 with the test results, which are read as plain text, so the
+ * target leaves it off. Define DEBUG_TRACE when UART1 is captured for trace_decode. A record
+ * costs one 8 byte ring buffer copy, so a traced build can stay in service.
+ * This header is also compiled into the host decoder, so it only depends on stdint.h.
+ */
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <stdint.h>
+
+#define TRACE_SYNC 0xA5	/* first byte of every record */
+
+/* X(id, name): every event that can be traced, in the order of their ids */
+#define TRACE_EVENTS(X) \
+	X(TRACE_SWITCH,        "switch")        /* pid stopped running, arg is the pid that runs next */ \
+	X(TRACE_MEM_BLOCKED,   "mem-blocked")   /* pid blocked because the heap is empty */ \
+	X(TRACE_MEM_UNBLOCKED, "mem-unblocked") /* pid released a block, arg is the pid it unblocked */ \
+	X(TRACE_SEND,          "send")          /* pid sent a message, arg is the receiving pid */ \
+	X(TRACE_RECV_BLOCKED,  "recv-blocked")  /* pid blocked waiting for a message */ \
+	X(TRACE_TIMER_FIRE,    "timer-fire")    /* a timer expired, arg is the pid it delivers to or wakes */ \
+	X(TRACE_UART_IRQ,      "uart-irq")      /* the UART i-process ran, arg is the IIR interrupt id */
+
+#define TRACE_ENUM_ENTRY(id, name) id,
+typedef enum {
+	TRACE_EVENTS(TRACE_ENUM_ENTRY)
+	NUM_TRACE_EVENTS
+} TRACE_EVENT_E;
+#undef TRACE_ENUM_ENTRY
+
+/* 8 byte event record, multi-byte fields are little endian */
+typedef struct trace_record
+{
+	uint8_t m_sync;		/* TRACE_SYNC */
+	uint8_t m_event;	/* TRACE_EVENT_E */
+	uint8_t m_pid;		/* process the event happened to */
+	uint8_t m_arg;		/* event specific, see TRACE_EVENTS */
+	uint32_t m_time;	/* low 32 bits of the monotonic clock, in microseconds */
+} TRACE_RECORD;
+
+#ifdef DEBUG_TRACE
+#define TRACE(event, pid, arg) trace_event(event, pid, arg)
+#else
+#define TRACE(event, pid, arg)
+#endif /* DEBUG_TRACE */
+
+void trace_event(uint8_t event, uint8_t pid, uint8_t arg); /* queue a record on the debug console */
+
+#endif /* ! TRACE_H_ */
@@ -55,6 +55,11 @@
 //#define UART_8N1  0x83
 						 
 
+#define UART_FIFO_SIZE 16	/* bytes the TX and RX FIFOs each hold */
+#define SZ_UART_TX 0x100	/* UART0 transmit buffer size is 256 B */
+#define SZ_INPUT_LINE 50	/* longest command line typed into UART0, including the null terminator */
+#define FRAME_TIMEOUT_MS 100	/* a frame missing bytes for this long is abandoned */
+
 #define uart0_irq_init() uart_irq_init(0)
 #define uart1_irq_init() uart_irq_init(1)       
      
@@ -31,6 +31,8 @@
 #define BUFSIZE		0x40
 /* end of NXP uart.h file reference */
 
+#define IIR_ID_MASK	0x07	/* interrupt identification, after shifting out the pending bit */
+
 
 #define BIT(X)(1 << (X))/* convenient macro for bit operation */
 
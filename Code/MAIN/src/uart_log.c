@@ -0,0 +1,185 @@
+/**
+ * @file:   uart_log.c
+ * @brief:  Interrupt-driven debug console on UART1. Output is queued in a ring buffer
+ *          and the UART1 interrupt refills the TX FIFO from it, so callers never poll.
+ */
+
+#include <LPC17xx.h>
+#include "uart_log.h"
+#include "log_fmt.h"
+#include "uart.h"
+#include "uart_polling.h"
+#include "ring_buffer.h"
+
+/* ----- Global Variables ----- */
+char g_log_data[SZ_LOG_BUFFER];  // Storage for g_log_buffer
+RingBuffer g_log_buffer = { g_log_data, SZ_LOG_BUFFER, 0, 0 }; // Output waiting for UART1, usable before log_init
+volatile uint32_t g_log_dropped = 0; // Bytes that didn't fit in g_log_buffer
+
+/**
+ * @brief: Sets UART1 up with its FIFOs enabled and only the THRE interrupt, which is
+ *         enabled whenever there is output waiting
+ */
+void log_init(void)
+{
+	LPC_UART_TypeDef* pUart = (LPC_UART_TypeDef*) LPC_UART1;
+	
+	uart1_init(); // pins, 8N1 and 115200 baud
+	
+	pUart->FCR = 0x07; // enable and clear the Rx and Tx FIFOs
+	pUart->IER = rb_empty(&g_log_buffer) ? 0 : IER_THRE;
+	
+	NVIC_EnableIRQ(UART1_IRQn);
+}
+
+/**
+ * @brief: Queues up to len bytes for UART1, dropping what doesn't fit
+ * NOTE: Can be called from anywhere, including interrupt handlers and with interrupts disabled
+ * @return: The number of bytes queued
+ */
+int log_write(const char* buf, int len)
+{
+	uint32_t primask = __get_PRIMASK();
+	int written;
+	
+	__disable_irq(); // atomic(on)
+	
+	written = rb_write(&g_log_buffer, buf, len);
+	g_log_dropped += len - written;
+	((LPC_UART_TypeDef*) LPC_UART1)->IER |= IER_THRE;
+	
+	// Leave interrupts disabled if the caller had them disabled
+	if (!primask) {
+		__enable_irq(); // atomic(off)
+	}
+	
+	return written;
+}
+
+/**
+ * @brief: Queues all len bytes for UART1, or drops all of them if they don't fit,
+ *         so that binary records are never cut short
+ * NOTE: Can be called from anywhere, including interrupt handlers and with interrupts disabled
+ * @return: len if the bytes were queued, 0 if they were dropped
+ */
+int log_write_record(const char* buf, int len)
+{
+	uint32_t primask = __get_PRIMASK();
+	int written = 0;
+	
+	__disable_irq(); // atomic(on)
+	
+	if (rb_space(&g_log_buffer) >= len) {
+		written = log_write(buf, len);
+	}
+	else {
+		g_log_dropped += len;
+	}
+	
+	// Leave interrupts disabled if the caller had them disabled
+	if (!primask) {
+		__enable_irq(); // atomic(off)
+	}
+	
+	return written;
+}
+
+/**
+ * @brief: Queues a log record holding the id of its format string and its argument words,
+ *         leaving the formatting to the host
+ * NOTE: Can be called from anywhere, including interrupt handlers and with interrupts disabled
+ */
+void log_deferred(uint8_t id, uint8_t num_args, uint32_t a0, uint32_t a1, uint32_t a2)
+{
+	char record[4 + 4 * LOG_MAX_ARGS];
+	uint32_t args[LOG_MAX_ARGS];
+	int i;
+	int j;
+	
+	args[0] = a0;
+	args[1] = a1;
+	args[2] = a2;
+	
+	record[0] = (char)LOG_SYNC;
+	record[1] = id;
+	record[2] = num_args;
+	record[3] = 0;
+	for (i = 0; i < num_args; i++) {
+		for (j = 0; j < 4; j++) {
+			record[4 + 4 * i + j] = (char)(args[i] >> (8 * j));
+		}
+	}
+	
+	log_write_record(record, 4 + 4 * num_args);
+}
+
+/**
+ * @brief: Queues a character for UART1
+ */
+void log_put_char(char c)
+{
+	log_write(&c, 1);
+}
+
+/**
+ * @brief: Queues a null terminated string for UART1
+ */
+void log_put_string(const char* s)
+{
+	int len = 0;
+	
+	while (s[len] != '\0') {
+		len++;
+	}
+	log_write(s, len);
+}
+
+/**
+ * @brief: call back function for printf
+ * NOTE: first parameter p is not used
+ */
+void log_putc(void* p, char c)
+{
+	log_write(&c, 1);
+}
+
+/**
+ * @brief: Gets the number of bytes dropped because the buffer was full
+ */
+uint32_t log_dropped(void)
+{
+	return g_log_dropped;
+}
+
+/**
+ * @brief: UART1 IRQ Handler. Refills the empty TX FIFO from the buffer,
+ *         and stops the THRE interrupt once there is nothing left to send
+ */
+void UART1_IRQHandler(void)
+{
+	LPC_UART_TypeDef* pUart = (LPC_UART_TypeDef*) LPC_UART1;
+	char chars[UART_FIFO_SIZE];
+	int num_chars;
+	int i;
+	uint8_t iir;
+	
+	__disable_irq(); // atomic(on)
+	
+	/* Reading IIR acknowledges THRE, the only interrupt enabled */
+	while (!((iir = pUart->IIR) & IIR_PEND)) {
+		if (((iir >> 1) & IIR_ID_MASK) != IIR_THRE) {
+			(void)pUart->LSR; // Clear anything else that is pending
+			continue;
+		}
+		
+		num_chars = rb_read(&g_log_buffer, chars, UART_FIFO_SIZE);
+		if (num_chars == 0) {
+			pUart->IER &= ~IER_THRE;
+		}
+		for (i = 0; i < num_chars; i++) {
+			pUart->THR = chars[i];
+		}
+	}
+	
+	__enable_irq(); // atomic(off)
+}
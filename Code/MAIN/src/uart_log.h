@@ -0,0 +1,26 @@
+/**
+ * @file:   uart_log.h
+ * @brief:  Interrupt-driven debug console on UART1
+ *
+ * NOTE:
+ * Writes never wait for UART1. They copy into a ring buffer that the UART1
+ * interrupt drains a FIFO at a time, and whatever doesn't fit is dropped and
+ * counted, so logging can be left on in i-processes and the kernel.
+ */
+
+#ifndef UART_LOG_H_
+#define UART_LOG_H_
+
+#include <stdint.h>
+
+#define SZ_LOG_BUFFER 0x400	/* debug console buffer size is 1 KB */
+
+void log_init(void);						/* initialize UART1 for the debug console */
+int log_write(const char* buf, int len);	/* queue len bytes, returns the number queued */
+int log_write_record(const char* buf, int len);	/* queue all len bytes or none of them */
+void log_put_char(char c);					/* queue a character */
+void log_put_string(const char* s);			/* queue a null terminated string */
+void log_putc(void* p, char c);				/* call back function for printf */
+uint32_t log_dropped(void);					/* number of bytes dropped because the buffer was full */
+
+#endif /* ! UART_LOG_H_ */
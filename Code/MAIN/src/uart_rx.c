@@ -0,0 +1,136 @@
+/**
+ * @file:   uart_rx.c
+ * @brief:  UART0 receive path. Characters drained from the RX FIFO are either part of a frame
+ *          from a machine client, which is sent to the KCD whole, or typed by the user, in which
+ *          case they are echoed and collected into a line that is sent to the KCD on ENTER.
+ */
+
+#include <LPC17xx.h>
+#include "uart.h"
+#include "k_rtx.h"
+#include "uart_rx.h"
+#include "uart_tx.h"
+#include "string.h"
+
+extern volatile uint32_t g_timer_count;
+
+char g_input_line[SZ_INPUT_LINE] = ""; // Command line the user is currently typing
+int g_input_length = 0;         // Number of characters in g_input_line
+int g_kcd_port = RTX_ERR;       // Port the UART i-process sends completed lines to
+
+/* Framed console input */
+#define FRAME_IDLE    0 // Between frames, input goes through the line discipline
+#define FRAME_LENGTH  1 // FRAME_SOF received, waiting for the length byte
+#define FRAME_PAYLOAD 2 // Receiving the payload
+int g_frame_state = FRAME_IDLE;
+char g_frame[SZ_FRAME_PAYLOAD + 1]; // Payload of the frame being received
+int g_frame_length = 0;             // Length from the frame's header
+int g_frame_received = 0;           // Number of payload bytes received so far
+int g_frame_valid = 0;              // Whether the payload fits in a message and has no null bytes so far
+uint32_t g_frame_time = 0;          // g_timer_count when the last byte of the frame arrived
+
+/**
+ * @brief: Sends a completed line or frame to the KCD. Without a free memory block, or while the KCD
+ *         hasn't opened its port yet, it is dropped like characters typed past the end of a line
+ */
+void uart_send_to_kcd(int mtype, const char* text)
+{
+	MSG_BUF* line = (MSG_BUF*)ki_request_memory_block();
+	if (line != NULL) {
+		line->mtype = mtype;
+		strcpy(line->mtext, text);
+		// Resolve the KCD's port the first time a line is sent to it
+		if (g_kcd_port == RTX_ERR) {
+			g_kcd_port = k_lookup_port("KCD");
+		}
+		if (k_send_to_port(g_kcd_port, line) == RTX_ERR) {
+			k_release_memory_block(line);
+		}
+	}
+}
+
+/**
+ * @brief: Receives one byte of a framed command. The whole payload is sent to the KCD at once,
+ *         without echo. Payloads that are too long for a message or contain a null byte (which
+ *         would cut the command short) are still consumed to stay in sync with the client,
+ *         but are sent empty so the KCD rejects them.
+ */
+void uart_frame_receive(char char_in)
+{
+	g_frame_time = g_timer_count;
+	
+	switch (g_frame_state) {
+		case FRAME_IDLE: // char_in is FRAME_SOF
+			g_frame_state = FRAME_LENGTH;
+			return;
+		case FRAME_LENGTH:
+			g_frame_length = (U8)char_in;
+			g_frame_received = 0;
+			g_frame_valid = g_frame_length <= SZ_FRAME_PAYLOAD;
+			g_frame_state = FRAME_PAYLOAD;
+			break;
+		default:
+			if (char_in == '\0') {
+				g_frame_valid = 0;
+			}
+			if (g_frame_received < SZ_FRAME_PAYLOAD) {
+				g_frame[g_frame_received] = char_in;
+			}
+			g_frame_received++;
+			break;
+	}
+	
+	if (g_frame_received == g_frame_length) {
+		g_frame[g_frame_valid ? g_frame_length : 0] = '\0';
+		uart_send_to_kcd(FRAMED_INPUT, g_frame);
+		g_frame_state = FRAME_IDLE;
+	}
+}
+
+/**
+ * @brief: Passes a character to the frame receiver if it starts a frame or one is in progress.
+ *         Frames from machine clients bypass the hotkeys and the line discipline.
+ * @return: 1 if the character was part of a frame, 0 if it was typed by the user
+ */
+int uart_frame_input(char char_in)
+{
+	// A client that stopped partway through a frame must not swallow the next input
+	if (g_frame_state != FRAME_IDLE && g_timer_count - g_frame_time > FRAME_TIMEOUT_MS) {
+		g_frame_state = FRAME_IDLE;
+	}
+	if (g_frame_state != FRAME_IDLE || char_in == FRAME_SOF) {
+		uart_frame_receive(char_in);
+		return 1;
+	}
+	return 0;
+}
+
+/**
+ * @brief: Line discipline for UART0 input. Echoes each character straight into the TX buffer,
+ *         handles BACKSPACE, and sends the KCD one message with the whole line on ENTER
+ */
+void uart_line_discipline(LPC_UART_TypeDef* pUart, char char_in)
+{
+	if (char_in == '\r') { // The user pressed ENTER
+		uart_tx_write(pUart, "\r\n", 2);
+		
+		if (g_input_length > 0) {
+			uart_send_to_kcd(USER_INPUT, g_input_line);
+		}
+		
+		// Reset the line
+		g_input_line[0] = '\0';
+		g_input_length = 0;
+	}
+	else if (char_in == '\b' || char_in == 127) { // The user pressed BACKSPACE
+		if (g_input_length > 0) {
+			g_input_line[--g_input_length] = '\0';
+			uart_tx_write(pUart, "\b \b", 3); // Erase the character on the terminal too
+		}
+	}
+	else if (g_input_length < SZ_INPUT_LINE - 1) {
+		g_input_line[g_input_length++] = char_in;
+		g_input_line[g_input_length] = '\0';
+		uart_tx_write(pUart, &char_in, 1);
+	}
+}
@@ -0,0 +1,14 @@
+/**
+ * @file:   uart_rx.h
+ * @brief:  UART0 receive path header file
+ */
+
+#ifndef UART_RX_H_
+#define UART_RX_H_
+
+#include <LPC17xx.h>
+
+int uart_frame_input(char char_in);	/* feed a character to the frame receiver, returns 1 if it was part of a frame */
+void uart_line_discipline(LPC_UART_TypeDef* pUart, char char_in);	/* echo and edit a typed character */
+
+#endif /* ! UART_RX_H_ */
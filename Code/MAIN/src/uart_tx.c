@@ -0,0 +1,94 @@
+/**
+ * @file:   uart_tx.c
+ * @brief:  UART0 transmit path. CRT_DISPLAY messages sent to the UART i-process and echoed
+ *          input are copied into a ring buffer, and the UART i-process moves it into the
+ *          TX FIFO a FIFO at a time whenever THRE fires.
+ */
+
+#include <LPC17xx.h>
+#include "uart.h"
+#include "k_rtx.h"
+#include "uart_tx.h"
+#include "ring_buffer.h"
+
+char g_tx_data[SZ_UART_TX];    // Storage for g_tx_buffer
+RingBuffer g_tx_buffer;         // Characters waiting to be written to UART0's TX FIFO
+MSG_BUF* gp_tx_message = NULL;  // CRT_DISPLAY message being copied into g_tx_buffer
+char* gp_buffer = NULL;         // Next character of gp_tx_message to copy
+
+/**
+ * @brief: Empties the TX buffer. Called while UART0 is initialized
+ */
+void uart_tx_init(void)
+{
+	init_rb(&g_tx_buffer, g_tx_data, SZ_UART_TX);
+	gp_tx_message = NULL;
+	gp_buffer = NULL;
+}
+
+/**
+ * @brief: Copies the CRT_DISPLAY messages waiting for the UART i-process into the TX buffer
+ *         until it is full, releasing each message once all of it has been copied
+ */
+void uart_tx_load_messages(void)
+{
+	while (!rb_full(&g_tx_buffer)) {
+		if (gp_tx_message == NULL) {
+			gp_tx_message = (MSG_BUF*)ki_receive_message((int*)0);
+			if (gp_tx_message == NULL) {
+				return;
+			}
+			gp_buffer = gp_tx_message->mtext;
+		}
+		
+		while (*gp_buffer != '\0' && rb_write(&g_tx_buffer, gp_buffer, 1) == 1) {
+			gp_buffer++;
+		}
+		
+		if (*gp_buffer == '\0') {
+			k_release_memory_block((void*)gp_tx_message);
+			gp_tx_message = NULL;
+		}
+	}
+}
+
+/**
+ * @brief: Refills UART0's empty TX FIFO from the TX buffer,
+ *         and stops the THRE interrupt once there is nothing left to send
+ */
+void uart_tx_fill(LPC_UART_TypeDef* pUart)
+{
+	char chars[UART_FIFO_SIZE];
+	int num_chars;
+	int i;
+	
+	// The FIFO is empty when THRE fires, so it has room for a full FIFO's worth of characters
+	num_chars = rb_read(&g_tx_buffer, chars, UART_FIFO_SIZE);
+	if (num_chars == 0) {
+		pUart->IER &= ~IER_THRE;
+		return;
+	}
+	
+	for (i = 0; i < num_chars; i++) {
+		pUart->THR = chars[i];
+	}
+}
+
+/**
+ * @brief: Enables the THRE interrupt, so the UART i-process runs as soon as the TX FIFO is empty
+ * NOTE: Must be called with interrupts disabled, so it doesn't race with the UART i-process turning it off
+ */
+void uart_tx_start(void)
+{
+	LPC_UART0->IER |= IER_THRE;
+}
+
+/**
+ * @brief: Queues characters to be transmitted on UART0, and starts transmitting if it was idle
+ *         Characters that don't fit in the TX buffer are dropped.
+ */
+void uart_tx_write(LPC_UART_TypeDef* pUart, const char* chars, int len)
+{
+	rb_write(&g_tx_buffer, chars, len);
+	pUart->IER |= IER_THRE;
+}
@@ -0,0 +1,17 @@
+/**
+ * @file:   uart_tx.h
+ * @brief:  UART0 transmit path header file
+ */
+
+#ifndef UART_TX_H_
+#define UART_TX_H_
+
+#include <LPC17xx.h>
+
+void uart_tx_init(void);						/* empty the TX buffer */
+void uart_tx_load_messages(void);				/* copy waiting CRT_DISPLAY messages into the TX buffer */
+void uart_tx_fill(LPC_UART_TypeDef* pUart);		/* refill the empty TX FIFO, or stop THRE if there is nothing to send */
+void uart_tx_write(LPC_UART_TypeDef* pUart, const char* chars, int len);	/* queue characters and start transmitting */
+void uart_tx_start(void);						/* enable THRE, call with interrupts disabled */
+
+#endif /* ! UART_TX_H_ */
@@ -8,6 +8,10 @@
 #include "string.h"
 #include "utils.h"
 
+#define PROC_A_BATCH_SIZE 4 /* number of count reports proc_a sends to proc_b per send_message_batch call */
+#define PROC_B_MAILBOX_LIMIT 8  /* number of count reports that can wait for proc_b before proc_a blocks */
+#define PROC_C_MAILBOX_LIMIT 8  /* number of count reports that can wait for proc_c before proc_b blocks */
+
 
 /**
  * @brief The Set Priority Command Process.
@@ -19,6 +23,7 @@ void set_priority_command_proc(void)
 	int priority;
 	MSG_BUF* msg_received;
 	MSG_BUF* msg_to_send;
+	int kcd_port = lookup_port("KCD");
 	
 	// Tell the KCD to register the "%C" command with the set priority command process
 	msg_to_send = (MSG_BUF*)request_memory_block();
@@ -26,7 +31,7 @@ void set_priority_command_proc(void)
 	msg_to_send->mtext[0] = '%';
 	msg_to_send->mtext[1] = 'C';
 	msg_to_send->mtext[2] = '\0';
-	send_message(PID_KCD, msg_to_send);
+	send_to_port(kcd_port, msg_to_send);
 	
 	while (1) {
 		// Initialize pid and priority to error
@@ -63,10 +68,7 @@ void set_priority_command_proc(void)
 			set_process_priority(pid, priority);
 		}
 		else {
-			msg_to_send = (MSG_BUF*)request_memory_block();
-			msg_to_send->mtype = CRT_DISPLAY;
-			strcpy(msg_to_send->mtext, "ERROR: Invalid input!\r\n");
-			send_message(PID_CRT, msg_to_send);
+			crt_printf("ERROR: Invalid input!\r\n");
 		}
 		
 		release_memory_block(msg_received);
@@ -80,16 +82,20 @@ void set_priority_command_proc(void)
  * the eternal loop where it gets blocked waiting for a message. Each time the wall clock
  * gets a new message, it performs the necessary actions and if it is in a "running" state,
  * it sends a message to the CRT to display the current time. Finally, the wall clock releases
- * the memory block of the message it received.
+ * the memory block of the message it received (which gives a tick back to its periodic timer).
  */
 void proc_wall_clock()
 {
 	int hours;
 	int minutes;
 	int seconds;
-	int mtype_validator = -1; // Validates messages to determine if the wall clock should run
+	int restart = 0;           // Whether or not to (re)start the tick and display the time
+	int ticks = 0;             // Number of seconds to advance the time by before displaying it
+	int tick_timer = RTX_ERR;  // Handle of the periodic timer that ticks every second while the clock runs
+	MSG_BUF* tick_msg = NULL;  // Notification delivered by tick_timer
 	MSG_BUF* msg_received;
 	MSG_BUF* msg_to_send;
+	int kcd_port = lookup_port("KCD");
 	
 	// Tell the KCD to register the "%WR" command with the wall clock process
 	msg_to_send = (MSG_BUF*)request_memory_block();
@@ -98,7 +104,7 @@ void proc_wall_clock()
 	msg_to_send->mtext[1] = 'W';
 	msg_to_send->mtext[2] = 'R';
 	msg_to_send->mtext[3] = '\0';
-	send_message(PID_KCD, msg_to_send);
+	send_to_port(kcd_port, msg_to_send);
 	
 	// Tell the KCD to register the "%WS" command with the wall clock process
 	msg_to_send = (MSG_BUF*)request_memory_block();
@@ -107,7 +113,7 @@ void proc_wall_clock()
 	msg_to_send->mtext[1] = 'W';
 	msg_to_send->mtext[2] = 'S';
 	msg_to_send->mtext[3] = '\0';
-	send_message(PID_KCD, msg_to_send);
+	send_to_port(kcd_port, msg_to_send);
 	
 	// Tell the KCD to register the "%WT" command with the wall clock process
 	msg_to_send = (MSG_BUF*)request_memory_block();
@@ -116,28 +122,19 @@ void proc_wall_clock()
 	msg_to_send->mtext[1] = 'W';
 	msg_to_send->mtext[2] = 'T';
 	msg_to_send->mtext[3] = '\0';
-	send_message(PID_KCD, msg_to_send);
+	send_to_port(kcd_port, msg_to_send);
 	
 	while (1) {
-		// Receive message from KCD (command input), or self (to display time)
+		// Receive message from KCD (command input), or the tick timer (to display time)
 		msg_received = (MSG_BUF*)receive_message(0);
+		restart = 0;
+		ticks = 0;
 		
 		if (msg_received->mtype == COMMAND) {
-			/* NOTE:
-			 * Changing the message type validator invalidates previous delay-sent messages
-			 * so only new messages are used to run the clock.
-			 */
-			
 			if (msg_received->mtext[2] == 'R') { // Reset and run clock
 				// Reset the time
 				hours = minutes = seconds = 0;
-				
-				mtype_validator = get_current_time(); // Change the message type validator
-				// If the message type validator happens to have been set to the COMMAND type, change it
-				if (mtype_validator == COMMAND) {
-					++mtype_validator;
-				}
-				msg_received->mtype = mtype_validator; // Set the message's type to the validator so the clock will run
+				restart = 1;
 			}
 			else if (msg_received->mtext[2] == 'S') { // Set clock running starting at a specified time
 				if (msg_received->mtext[3] == ' '
@@ -150,81 +147,67 @@ void proc_wall_clock()
 				        && msg_received->mtext[10] >= '0' && msg_received->mtext[10] <= '5'
 				        && msg_received->mtext[11] >= '0' && msg_received->mtext[11] <= '9'
 				        && hasWhiteSpaceToEnd(msg_received->mtext, 12)) {
-					// Use the input time to set the current time variables and set the message's type to the validator so the clock will run
+					// Use the input time to set the current time variables and start the clock running
 					hours = ctoi(msg_received->mtext[4]) * 10 + ctoi(msg_received->mtext[5]);
 					minutes = ctoi(msg_received->mtext[7]) * 10 + ctoi(msg_received->mtext[8]);
 					seconds = ctoi(msg_received->mtext[10]) * 10 + ctoi(msg_received->mtext[11]);
-					
-					mtype_validator = get_current_time(); // Change the message type validator
-					// If the message type validator happens to have been set to the COMMAND type, change it
-					if (mtype_validator == COMMAND) {
-						++mtype_validator;
-					}
-					msg_received->mtype = mtype_validator; // Set the message's type to the validator so the clock will run
+					restart = 1;
 				}
 				else { // Input was invalid
-					// Send a message to the CRT to display an error message
-					msg_to_send = (MSG_BUF*)request_memory_block();
-					msg_to_send->mtype = CRT_DISPLAY;
-					strcpy(msg_to_send->mtext, "ERROR: Invalid time!\r\n");
-					send_message(PID_CRT, msg_to_send);
+					crt_printf("ERROR: Invalid time!\r\n");
 				}
 			}
 			else if (msg_received->mtext[2] == 'T') { // Stop clock
-				mtype_validator = get_current_time(); // Change the message type validator so the clock will stop running
-				// If the message type validator happens to have been set to the COMMAND type, change it
-				if (mtype_validator == COMMAND) {
-					++mtype_validator;
-				}
+				stop_periodic_timer(tick_timer);
+				tick_timer = RTX_ERR;
+				tick_msg = NULL;
 			}
 		}
+		else if (msg_received->mtype == CLOCK_TICK && msg_received == tick_msg) {
+			// The timer tells us how many seconds went by since its last tick
+			// (ticks from a timer that was stopped don't match tick_msg, so they're just released)
+			ticks = *(int*)msg_received->mtext;
+		}
 		
-		if (msg_received->mtype == mtype_validator) {
-			// Send a message to the CRT to display the current time
-			msg_to_send = (MSG_BUF*)request_memory_block();
-			msg_to_send->mtype = CRT_DISPLAY;
-			
-			msg_to_send->mtext[0] = itoc(hours / 10);
-			msg_to_send->mtext[1] = itoc(hours % 10);
-			msg_to_send->mtext[2] = ':';
-			msg_to_send->mtext[3] = itoc(minutes / 10);
-			msg_to_send->mtext[4] = itoc(minutes % 10);
-			msg_to_send->mtext[5] = ':';
-			msg_to_send->mtext[6] = itoc(seconds / 10);
-			msg_to_send->mtext[7] = itoc(seconds % 10);
-			msg_to_send->mtext[8] = '\r';
-			msg_to_send->mtext[9] = '\n';
-			msg_to_send->mtext[10] = '\0';
-			
-			send_message(PID_CRT, (void*)msg_to_send);
-			
-			// Set the time for when the wall clock is run again (which should be in exactly 1 second)
-			if (++seconds >= 60) {
-				seconds = 0;
-				if (++minutes >= 60) {
-					minutes = 0;
-					if (++hours >= 24) {
-						hours = 0;
-					}
-				}
+		if (restart) {
+			// Stop the old tick so that it doesn't keep running the clock, and start a new one a second from now
+			stop_periodic_timer(tick_timer);
+			tick_msg = (MSG_BUF*)request_memory_block();
+			tick_msg->mtype = CLOCK_TICK;
+			tick_timer = start_periodic_timer(PID_CLOCK, tick_msg, 1000);
+			if (tick_timer == RTX_ERR) {
+				release_memory_block(tick_msg);
+				tick_msg = NULL;
 			}
+		}
+		
+		if (restart || ticks > 0) {
+			// Advance the time by the number of seconds that went by
+			seconds += ticks;
+			minutes += seconds / 60;
+			seconds %= 60;
+			hours += minutes / 60;
+			minutes %= 60;
+			hours %= 24;
 			
-			// Send a message to self in exactly 1 second to update and display the time
-			msg_to_send = (MSG_BUF*)request_memory_block();
-			msg_to_send->mtype = mtype_validator;
-			delayed_send(PID_CLOCK, msg_to_send, 1000);
+			// Send a message to the CRT to display the current time
+			crt_printf("%02d:%02d:%02d\r\n", hours, minutes, seconds);
 		}
 		
-		// Release the memory of the received message
+		// Release the memory of the received message (a tick goes back to its timer to be delivered again)
 		release_memory_block(msg_received);
 	}
 }
 
 void proc_a(void)
 {
+	int i;
 	int num = 0;
+	int pids[PROC_A_BATCH_SIZE];
+	void* batch[PROC_A_BATCH_SIZE];
 	MSG_BUF* msg_received;
 	MSG_BUF* msg_to_send;
+	int kcd_port = lookup_port("KCD");
 	
 	// Tell the KCD to register the "%Z" command
 	msg_to_send = (MSG_BUF*)request_memory_block();
@@ -232,7 +215,7 @@ void proc_a(void)
 	msg_to_send->mtext[0] = '%';
 	msg_to_send->mtext[1] = 'Z';
 	msg_to_send->mtext[2] = '\0';
-	send_message(PID_KCD, msg_to_send);
+	send_to_port(kcd_port, msg_to_send);
 	
 	// Wait for the "%Z" command and discard any other messages while waiting
 	while (1) {
@@ -244,19 +227,31 @@ void proc_a(void)
 		release_memory_block(msg_received);
 	}
 	
+	// Every message in a batch goes to proc_b
+	for (i = 0; i < PROC_A_BATCH_SIZE; i++) {
+		pids[i] = PID_B;
+	}
+	
 	num = 0;
 	while (1) {
-		msg_to_send = (MSG_BUF*)request_memory_block();
-		msg_to_send->mtype = COUNT_REPORT;
-		itoa(num, msg_to_send->mtext);
-		send_message(PID_B, msg_to_send);
-		num++;
+		// Build a batch of count reports and send them all with one kernel call
+		for (i = 0; i < PROC_A_BATCH_SIZE; i++) {
+			msg_to_send = (MSG_BUF*)request_memory_block();
+			msg_to_send->mtype = COUNT_REPORT;
+			itoa(num, msg_to_send->mtext);
+			batch[i] = msg_to_send;
+			num++;
+		}
+		send_message_batch(pids, batch, PROC_A_BATCH_SIZE);
 		release_processor();
 	}
 }
 
 void proc_b (void)
 {
+	// Bound the number of messages proc_a can queue up while proc_b is waiting on proc_c
+	set_mailbox_limit(PID_B, PROC_B_MAILBOX_LIMIT, MAILBOX_BLOCKING);
+	
 	while (1) {
 		MSG_BUF* msg_received = (MSG_BUF*)receive_message(0);
 		send_message(PID_C, msg_received);
@@ -265,43 +260,26 @@ void proc_b (void)
 
 void proc_c (void)
 {
-	MSG_BUF* msg_to_send;
 	MSG_BUF* msg_received;
-	Queue local_message_q;
+	int length;
 	
-	init_q(&local_message_q);
+	// Bound the number of messages proc_b can queue up while proc_c is busy
+	set_mailbox_limit(PID_C, PROC_C_MAILBOX_LIMIT, MAILBOX_BLOCKING);
 	
 	while (1) {
-		if (q_empty(&local_message_q)) {
-			msg_received = (MSG_BUF*)receive_message(0);
+		msg_received = (MSG_BUF*)receive_message(0);
+		
+		length = msg_received->mtype == COUNT_REPORT ? strlen(msg_received->mtext) : 0;
+		if (length > 1 && msg_received->mtext[length - 2] % 2 == 0 && msg_received->mtext[length - 1] == '0') {
+			release_memory_block(msg_received);
+			crt_printf("Process C\r\n");
+			
+			// hibernate (count reports from proc_b wait in the mailbox in the meantime)
+			sleep(10000);
 		}
 		else {
-			msg_received = (MSG_BUF*)envelope_to_message((MSG_ENVELOPE*)dequeue(&local_message_q));
-		}
-		
-		if (msg_received->mtype == COUNT_REPORT) {
-			int length = strlen(msg_received->mtext);
-			if (length > 1 && msg_received->mtext[length - 2] % 2 == 0 && msg_received->mtext[length - 1] == '0') {
-				msg_received->mtype = CRT_DISPLAY;
-				strcpy(msg_received->mtext, "Process C\r\n");
-				send_message(PID_CRT, msg_received);
-				
-				//hibernate
-				msg_to_send = (MSG_BUF*)request_memory_block();
-				msg_to_send->mtype = WAKEUP10;
-				delayed_send(PID_C, msg_to_send, 10000);
-				while (1) {
-					msg_received = (MSG_BUF*)receive_message(0);
-					if (msg_received->mtype == WAKEUP10) {
-						break;
-					}
-					else {
-						enqueue(&local_message_q, (QNode*)message_to_envelope(msg_received));
-					}
-				}
-			}
+			release_memory_block(msg_received);
 		}
-		release_memory_block(msg_received);
 		release_processor();
 	}
 }
@@ -5,9 +5,11 @@
  * @date:   2014/03/13
  */
 
- #include <limits.h>
- #include <math.h>
- #include <stdlib.h>
+ #include "rtx.h"
+ #include "printf.h"
+ #include "utils.h"
+
+int g_crt_port = RTX_ERR; // Port of the CRT, looked up the first time crt_printf is called
 
 int ctoi(char c)
 {
@@ -31,31 +33,84 @@ int hasWhiteSpaceToEnd(char* s, int n)
 	return 1;
 }
 
-char* itoa (int n, char* str)
+char* uitoa(unsigned int n, unsigned int base, int upper, int width, char pad, char* str)
+{
+	char digits[32]; // Enough for the longest (base 2) representation of an unsigned int
+	int num_digits = 0;
+	int i = 0;
+	
+	// Peel off the digits from least to most significant with one division each
+	do {
+		unsigned int quotient = n / base;
+		unsigned int digit = n - quotient * base;
+		digits[num_digits++] = digit < 10 ? '0' + digit : (upper ? 'A' : 'a') + digit - 10;
+		n = quotient;
+	} while (n != 0);
+	
+	// Pad on the left, then copy the digits back out in order
+	while (width-- > num_digits) {
+		str[i++] = pad;
+	}
+	while (num_digits > 0) {
+		str[i++] = digits[--num_digits];
+	}
+	str[i] = '\0';
+	
+	return str;
+}
+
+char* itoaPad(int n, int width, char pad, char* str)
 {
-	if (n == 0) {
-		str[0] = '0';
-		str[1] = '\0';
+	// Negate as unsigned so INT_MIN doesn't overflow
+	unsigned int magnitude = n < 0 ? 0u - (unsigned int)n : (unsigned int)n;
+	char* first_digit;
+	
+	if (n >= 0) {
+		return uitoa(magnitude, 10, 0, width, pad, str);
+	}
+	
+	// Leave room for the sign, then put it right before the first digit (zero padding goes after the sign)
+	str[0] = pad;
+	uitoa(magnitude, 10, 0, width - 1, pad, str + 1);
+	if (pad == '0') {
+		str[0] = '-';
 	}
 	else {
-		int i = 0;
-		
-		// Handle the case where n is negative
-		if (n < 0) {
-			str[0] = '-';
-			i = 1;
-		}
-		
-		// Add the number of digits in n to i (handle special case when n == INT_MIN)
-		i += log10(n == INT_MIN ? INT_MAX : abs(n)) + 1;
-		
-		// Build the string
-		str[i] = '\0';
-		while (n) {
-			str[--i] = itoc(abs(n % 10));
-			n /= 10;
+		first_digit = str + 1;
+		while (*first_digit == pad) {
+			first_digit++;
 		}
+		first_digit[-1] = '-';
 	}
 	
 	return str;
 }
+
+char* itoa (int n, char* str)
+{
+	return itoaPad(n, 0, ' ', str);
+}
+
+int crt_printf(char* fmt, ...)
+{
+	MSG_BUF* message;
+	va_list va;
+	
+	if (g_crt_port == RTX_ERR) {
+		g_crt_port = lookup_port("CRT");
+	}
+	
+	// Format straight into the message, cutting the text off if it doesn't fit
+	message = (MSG_BUF*)request_memory_block();
+	message->mtype = CRT_DISPLAY;
+	va_start(va, fmt);
+	tfp_vsnprintf(message->mtext, SZ_MTEXT, fmt, va);
+	va_end(va);
+	
+	// The message is still ours if it couldn't be sent, so give it back rather than leak it
+	if (send_to_port(g_crt_port, message) == RTX_ERR) {
+		release_memory_block(message);
+		return RTX_ERR;
+	}
+	return RTX_OK;
+}
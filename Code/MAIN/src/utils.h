@@ -35,6 +35,32 @@ char itoc(int i);
  */
 int hasWhiteSpaceToEnd(char* s, int n);
 
+/**
+ * Converts an unsigned integer to a null-terminated string and stores the result in the array given by the str parameter.
+ * Uses only integer arithmetic (one division per digit).
+ *
+ * @param {unsigned int} n - Integer to be converted to a string.
+ * @param {unsigned int} base - Base of the result, from 2 to 16.
+ * @param {int} upper - Non-zero to use upper case letters for digits above 9.
+ * @param {int} width - Minimum length of the result; shorter results are padded on the left.
+ * @param {char} pad - Character to pad with (usually ' ' or '0').
+ * @param {char*} str - Array in memory where to store the resulting null-terminated string.
+ * @returns {char*} A pointer to the resulting null-terminated string, same as parameter str.
+ */
+char* uitoa(unsigned int n, unsigned int base, int upper, int width, char pad, char* str);
+
+/**
+ * Converts an integer to a base 10 null-terminated string padded on the left to the given width.
+ * Zero padding goes between the sign and the digits ("-007"); any other padding goes before the sign ("  -7").
+ *
+ * @param {int} n - Integer to be converted to a string.
+ * @param {int} width - Minimum length of the result, including the sign.
+ * @param {char} pad - Character to pad with (usually ' ' or '0').
+ * @param {char*} str - Array in memory where to store the resulting null-terminated string.
+ * @returns {char*} A pointer to the resulting null-terminated string, same as parameter str.
+ */
+char* itoaPad(int n, int width, char pad, char* str);
+
 /**
  * Converts an integer to a null-terminated string and stores the result in the array given by the str parameter.
  * NOTE: Assumes the integer is base 10.
@@ -45,4 +71,14 @@ int hasWhiteSpaceToEnd(char* s, int n);
  */
 char* itoa (int n, char* str);
 
+/**
+ * Formats a string like printf into a new message and sends it to the CRT to be displayed.
+ * Text that doesn't fit in the message (SZ_MTEXT - 1 characters) is cut off.
+ * NOTE: Blocks while there are no free memory blocks.
+ *
+ * @param {char*} fmt - The format string, supporting the conversions of tfp_printf (d u c s x X, width and zero padding).
+ * @returns {int} RTX_OK if the message was sent to the CRT; else RTX_ERR, and the message is released.
+ */
+int crt_printf(char* fmt, ...);
+
 #endif /* UTILS_H_ */
@@ -0,0 +1,32 @@
+/**
+ * @file:   LPC17xx.h
+ * @brief:  Stand-in for the device header, so firmware sources that only touch UART0's
+ *          registers or mask interrupts can be compiled into host tools. A write to THR
+ *          stores into the slot of fifo returned by fake_uart_thr_slot(), which the tool
+ *          implements to model the TX FIFO. Masking interrupts does nothing, since host
+ *          tools have no interrupts.
+ */
+
+#ifndef FAKE_LPC17XX_H_
+#define FAKE_LPC17XX_H_
+
+#include <stdint.h>
+
+/* Keil intrinsics used by the kernel headers */
+#define __svc_indirect(x)
+#define __disable_irq()
+#define __enable_irq()
+
+typedef struct
+{
+	volatile uint8_t fifo[16];	/* the 16 byte TX FIFO, written through the THR macro */
+	volatile uint32_t IER;
+} LPC_UART_TypeDef;
+
+int fake_uart_thr_slot(void);	/* called once per write to THR, returns the slot of fifo to store into */
+#define THR fifo[fake_uart_thr_slot()]
+
+extern LPC_UART_TypeDef g_fake_uart0;
+#define LPC_UART0 (&g_fake_uart0)
+
+#endif /* ! FAKE_LPC17XX_H_ */
@@ -0,0 +1,179 @@
+/**
+ * @file:   itoa_bench.c
+ * @brief:  Host check and benchmark of the integer formatting in src/utils.c. Compares
+ *          uitoa, itoaPad and itoa against sprintf for edge cases, padded widths and random
+ *          values, then times them against the versions they replaced (the log10-based itoa
+ *          and printf.c's ui2a, kept below as they were).
+ *
+ * Build:   cc -O2 -D'__svc_indirect(x)=' -o itoa_bench itoa_bench.c ../src/utils.c ../src/printf.c -lm
+ * Usage:   itoa_bench [iterations]   (exits non-zero if any result differs from sprintf)
+ *
+ * NOTE: On 64-bit hosts, crt_printf's SVC wrappers warn about casting function pointers
+ *       to U32. crt_printf is never called here, so the warnings are harmless.
+ */
+
+#include "../src/rtx.h"
+#include "../src/utils.h"
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define NUM_ITERATIONS 20000000	/* conversions timed per function by default */
+
+/* utils.c's crt_printf is linked in but never called here */
+void* k_request_memory_block(void) { return NULL; }
+int k_lookup_port(const char* name) { return RTX_ERR; }
+int k_send_to_port(int port_id, void* p_msg) { return RTX_ERR; }
+int k_release_memory_block(void* p_mem_blk) { return RTX_ERR; }
+void* _request_memory_block(U32 p_func) { return NULL; }
+int _lookup_port(U32 p_func, const char* name) { return RTX_ERR; }
+int _send_to_port(U32 p_func, int port_id, void* p_msg) { return RTX_ERR; }
+int _release_memory_block(U32 p_func, void* p_mem_blk) { return RTX_ERR; }
+
+/**
+ * @brief: itoa as it was before it was made integer-only
+ */
+static char* old_itoa(int n, char* str)
+{
+	if (n == 0) {
+		str[0] = '0';
+		str[1] = '\0';
+	}
+	else {
+		int i = 0;
+
+		if (n < 0) {
+			str[0] = '-';
+			i = 1;
+		}
+
+		i += log10(n == INT_MIN ? INT_MAX : abs(n)) + 1;
+
+		str[i] = '\0';
+		while (n) {
+			str[--i] = itoc(abs(n % 10));
+			n /= 10;
+		}
+	}
+
+	return str;
+}
+
+/**
+ * @brief: printf.c's ui2a as it was before it was replaced by uitoa
+ */
+static void old_ui2a(unsigned int num, unsigned int base, int uc, char* bf)
+{
+	int n = 0;
+	unsigned int d = 1;
+	while (num / d >= base)
+		d *= base;
+	while (d != 0) {
+		int dgt = num / d;
+		num %= d;
+		d /= base;
+		if (n || dgt > 0 || d == 0) {
+			*bf++ = dgt + (dgt < 10 ? '0' : (uc ? 'A' : 'a') - 10);
+			++n;
+		}
+	}
+	*bf = 0;
+}
+
+static int g_failures = 0;
+
+/**
+ * @brief: Reports a result that differs from sprintf's
+ */
+static void check(const char* what, int n, const char* got, const char* expected)
+{
+	if (strcmp(got, expected) != 0) {
+		printf("FAIL: %s(%d) gave \"%s\", expected \"%s\"\n", what, n, got, expected);
+		g_failures++;
+	}
+}
+
+/**
+ * @brief: Checks every conversion of n against sprintf
+ */
+static void check_value(int n)
+{
+	char got[40];
+	char expected[40];
+
+	sprintf(expected, "%d", n);
+	check("itoa", n, itoa(n, got), expected);
+	sprintf(expected, "%6d", n);
+	check("itoaPad ' '", n, itoaPad(n, 6, ' ', got), expected);
+	sprintf(expected, "%06d", n);
+	check("itoaPad '0'", n, itoaPad(n, 6, '0', got), expected);
+	sprintf(expected, "%u", (unsigned int)n);
+	check("uitoa 10", n, uitoa(n, 10, 0, 0, ' ', got), expected);
+	sprintf(expected, "%08x", (unsigned int)n);
+	check("uitoa 16", n, uitoa(n, 16, 0, 8, '0', got), expected);
+	sprintf(expected, "%X", (unsigned int)n);
+	check("uitoa 16 upper", n, uitoa(n, 16, 1, 0, ' ', got), expected);
+}
+
+/**
+ * @brief: Spreads i over the whole range of int, so every length of number is timed
+ */
+static int spread(int i)
+{
+	return (int)((unsigned int)i * 2654435761u);
+}
+
+int main(int argc, char* argv[])
+{
+	static const int edge_cases[] = { 0, 1, -1, 9, 10, -10, 99999, 100000, -100000, INT_MAX, INT_MIN };
+	int iterations = argc > 1 ? atoi(argv[1]) : NUM_ITERATIONS;
+	char str[40];
+	unsigned int sink = 0;
+	clock_t start;
+	int i;
+
+	for (i = 0; i < (int)(sizeof(edge_cases) / sizeof(edge_cases[0])); i++) {
+		check_value(edge_cases[i]);
+	}
+	for (i = 0; i < 100000; i++) {
+		check_value(spread(i));
+	}
+
+	start = clock();
+	for (i = 0; i < iterations; i++) {
+		sink += old_itoa(spread(i), str)[1];
+	}
+	printf("old itoa:  %.3f s\n", (double)(clock() - start) / CLOCKS_PER_SEC);
+
+	start = clock();
+	for (i = 0; i < iterations; i++) {
+		sink += itoa(spread(i), str)[1];
+	}
+	printf("itoa:      %.3f s\n", (double)(clock() - start) / CLOCKS_PER_SEC);
+
+	start = clock();
+	for (i = 0; i < iterations; i++) {
+		old_ui2a(spread(i), 10, 0, str);
+		sink += str[1];
+	}
+	printf("old ui2a:  %.3f s\n", (double)(clock() - start) / CLOCKS_PER_SEC);
+
+	start = clock();
+	for (i = 0; i < iterations; i++) {
+		sink += uitoa(spread(i), 10, 0, 0, ' ', str)[1];
+	}
+	printf("uitoa:     %.3f s\n", (double)(clock() - start) / CLOCKS_PER_SEC);
+
+	// Use the results so the timed loops can't be optimized away
+	printf("%d conversions each (checksum %u)\n", iterations, sink);
+
+	if (g_failures > 0) {
+		printf("FAIL: %d results differ from sprintf\n", g_failures);
+		return 1;
+	}
+	printf("PASS\n");
+	return 0;
+}
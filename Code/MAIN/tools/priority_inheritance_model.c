@@ -0,0 +1,304 @@
+/**
+ * @file:   priority_inheritance_model.c
+ * @brief:  Host model of the mutexes in src/k_sync.c. The real lock, unlock and priority
+ *          inheritance code (update_priority_chain, remove_held_mutex) runs against the real
+ *          priority queues, with a model of the scheduler in place of k_process.c. Kernel calls
+ *          return straight away instead of switching stacks, so each scenario is a script of
+ *          calls made by whichever process the model scheduler says is running.
+ *          Checks the classic low/medium/high inversion, inheritance through a chain of
+ *          mutexes, a holder of two mutexes dropping one level at a time, and that every
+ *          priority is restored once the mutexes are unlocked.
+ *
+ * Build:   cc -I host -o priority_inheritance_model priority_inheritance_model.c ../src/k_sync.c ../src/priority_queue.c ../src/queue.c
+ * Usage:   priority_inheritance_model   (prints PASS or each failure, exits non-zero on failure)
+ */
+
+#include <LPC17xx.h>
+#include "../src/k_rtx.h"
+#include "../src/k_sync.h"
+#include "../src/k_process.h"
+#include <stdio.h>
+
+#define PID_LOW 1
+#define PID_MEDIUM 2
+#define PID_HIGH 3
+#define NUM_MODEL_PROCS 4	/* the three above and the null process */
+
+PCB g_procs[NUM_MODEL_PROCS];
+PCB* gp_current_process;
+PriorityQueue g_ready_pq;
+extern MUTEX g_mutexes[NUM_MUTEXES];	/* k_sync.c's pool, to check who owns each mutex */
+
+static int g_failures = 0;
+
+/**
+ * @brief: Picks the process to run and puts the old one back on the ready queue, like
+ *         scheduler() and configure_old_pcb() do, then "switches" to it
+ */
+int k_release_processor(void)
+{
+	PCB* top_pcb = (PCB*)top(&g_ready_pq);
+	PCB* old = gp_current_process;
+
+	if (!is_blocked(old) && (top_pcb == NULL || top_pcb->m_priority > old->m_priority)) {
+		return RTX_OK;
+	}
+
+	if (old->m_state == RUNNING) {
+		old->m_state = READY;
+		if (old->m_pid != PID_NULL) {
+			push(&g_ready_pq, (QNode*)old, old->m_priority);
+		}
+	}
+	gp_current_process = (PCB*)pop(&g_ready_pq);
+	if (gp_current_process == NULL) {
+		gp_current_process = &g_procs[PID_NULL];
+	}
+	gp_current_process->m_state = RUNNING;
+	return RTX_OK;
+}
+
+PCB* get_proc_by_pid(int pid)
+{
+	return pid >= 0 && pid < NUM_MODEL_PROCS ? &g_procs[pid] : NULL;
+}
+
+int is_blocked(PCB* pcb)
+{
+	return pcb->m_state != READY && pcb->m_state != RUNNING && pcb->m_state != NEW;
+}
+
+void make_ready(PCB* pcb)
+{
+	pcb->m_state = READY;
+	pcb->mp_blocked_pq = NULL;
+	push(&g_ready_pq, (QNode*)pcb, pcb->m_priority);
+}
+
+void preempt_current_process(void)
+{
+	k_release_processor();
+}
+
+/**
+ * @brief: Moves the process within the queue it is waiting in, like k_process.c's change_priority
+ */
+int change_priority(PCB* pcb, int priority)
+{
+	PriorityQueue* pqueue = NULL;
+
+	if (pcb->m_state == READY) {
+		pqueue = &g_ready_pq;
+	}
+	else if (pcb->m_state == BLOCKED_ON_MUTEX || pcb->m_state == BLOCKED_ON_SEMAPHORE) {
+		pqueue = pcb->mp_blocked_pq;
+	}
+
+	if (pqueue != NULL) {
+		if (!remove_at_priority(pqueue, (QNode*)pcb, pcb->m_priority)) {
+			return 0;
+		}
+		push(pqueue, (QNode*)pcb, priority);
+	}
+	pcb->m_priority = priority;
+	return 1;
+}
+
+/**
+ * @brief: Starts a scenario with every process READY at its own priority and the
+ *         process with the given PID running
+ */
+static void reset(int running_pid)
+{
+	int i;
+
+	sync_init();
+	init_pq(&g_ready_pq);
+	for (i = 0; i < NUM_MODEL_PROCS; i++) {
+		g_procs[i].m_pid = i;
+		g_procs[i].m_base_priority = g_procs[i].m_priority = i == PID_NULL ? LOWEST : LOW - (i - PID_LOW);
+		g_procs[i].m_is_iproc = 0;
+		g_procs[i].m_state = READY;
+		g_procs[i].mp_blocked_pq = NULL;
+		g_procs[i].mp_held_mutexes = NULL;
+		g_procs[i].mp_blocked_mutex = NULL;
+		if (i != PID_NULL && i != running_pid) {
+			push(&g_ready_pq, (QNode*)&g_procs[i], g_procs[i].m_priority);
+		}
+	}
+	gp_current_process = &g_procs[running_pid];
+	gp_current_process->m_state = RUNNING;
+}
+
+/**
+ * @brief: Blocks every process other than the one with the given PID, as if they were
+ *         waiting for messages, so that only it runs until it wakes them
+ */
+static void park_all_but(int pid)
+{
+	int i;
+
+	for (i = PID_LOW; i < NUM_MODEL_PROCS; i++) {
+		if (i != pid && g_procs[i].m_state == READY) {
+			remove_at_priority(&g_ready_pq, (QNode*)&g_procs[i], g_procs[i].m_priority);
+			g_procs[i].m_state = BLOCKED_ON_RECEIVE;
+		}
+	}
+}
+
+/**
+ * @brief: Wakes a parked process, letting it preempt the running one
+ */
+static void wake(int pid)
+{
+	make_ready(&g_procs[pid]);
+	preempt_current_process();
+}
+
+/**
+ * @brief: Blocks the running process, as if it were waiting for a message
+ */
+static void block(void)
+{
+	gp_current_process->m_state = BLOCKED_ON_RECEIVE;
+	k_release_processor();
+}
+
+static void check(int ok, const char* what)
+{
+	if (!ok) {
+		printf("FAIL: %s\n", what);
+		g_failures++;
+	}
+}
+
+static void check_priorities(int low, int medium, int high, const char* what)
+{
+	if (g_procs[PID_LOW].m_priority != low || g_procs[PID_MEDIUM].m_priority != medium
+	        || g_procs[PID_HIGH].m_priority != high) {
+		printf("FAIL: %s: priorities are %d %d %d, expected %d %d %d\n", what,
+		       g_procs[PID_LOW].m_priority, g_procs[PID_MEDIUM].m_priority, g_procs[PID_HIGH].m_priority,
+		       low, medium, high);
+		g_failures++;
+	}
+}
+
+/**
+ * @brief: LOW locks the mutex, then HIGH blocks on it while MEDIUM is ready. LOW must run
+ *         at HIGH until it unlocks, so MEDIUM can't keep HIGH waiting.
+ */
+static void test_inversion(void)
+{
+	int mutex;
+
+	reset(PID_LOW);
+	park_all_but(PID_LOW);
+	mutex = k_create_mutex();
+	check(k_lock_mutex(mutex) == RTX_OK, "inversion: LOW locks the mutex");
+
+	wake(PID_MEDIUM);
+	check(gp_current_process == &g_procs[PID_MEDIUM], "inversion: MEDIUM preempts LOW");
+	wake(PID_HIGH);
+	check(gp_current_process == &g_procs[PID_HIGH], "inversion: HIGH preempts MEDIUM");
+
+	k_lock_mutex(mutex);
+	check(g_procs[PID_HIGH].m_state == BLOCKED_ON_MUTEX, "inversion: HIGH blocks on the mutex");
+	check_priorities(HIGH, MEDIUM, HIGH, "inversion: LOW inherits HIGH");
+	check(gp_current_process == &g_procs[PID_LOW], "inversion: LOW runs ahead of MEDIUM");
+
+	check(k_unlock_mutex(mutex) == RTX_OK, "inversion: LOW unlocks the mutex");
+	check_priorities(LOW, MEDIUM, HIGH, "inversion: LOW's priority is restored");
+	check(gp_current_process == &g_procs[PID_HIGH], "inversion: HIGH runs once LOW unlocks");
+	check(g_mutexes[mutex].mp_owner == &g_procs[PID_HIGH], "inversion: the mutex is handed to HIGH");
+
+	check(k_unlock_mutex(mutex) == RTX_OK && g_mutexes[mutex].mp_owner == NULL, "inversion: HIGH unlocks the mutex");
+	check(g_procs[PID_LOW].mp_held_mutexes == NULL && g_procs[PID_HIGH].mp_held_mutexes == NULL,
+	      "inversion: nobody holds a mutex afterwards");
+}
+
+/**
+ * @brief: LOW holds the first mutex, MEDIUM holds the second and blocks on the first, then
+ *         HIGH blocks on the second. HIGH's priority must pass through MEDIUM to LOW.
+ */
+static void test_chain(void)
+{
+	int first;
+	int second;
+
+	reset(PID_LOW);
+	park_all_but(PID_LOW);
+	first = k_create_mutex();
+	second = k_create_mutex();
+	k_lock_mutex(first);
+
+	wake(PID_MEDIUM);
+	k_lock_mutex(second);
+	k_lock_mutex(first);
+	check(g_procs[PID_MEDIUM].m_state == BLOCKED_ON_MUTEX, "chain: MEDIUM blocks on the first mutex");
+	check_priorities(MEDIUM, MEDIUM, HIGH, "chain: LOW inherits MEDIUM");
+
+	wake(PID_HIGH);
+	k_lock_mutex(second);
+	check_priorities(HIGH, HIGH, HIGH, "chain: HIGH passes through MEDIUM to LOW");
+	check(gp_current_process == &g_procs[PID_LOW], "chain: LOW runs");
+
+	k_unlock_mutex(first);
+	check_priorities(LOW, HIGH, HIGH, "chain: LOW's priority is restored");
+	check(gp_current_process == &g_procs[PID_MEDIUM], "chain: MEDIUM runs with the first mutex");
+
+	k_unlock_mutex(first);
+	k_unlock_mutex(second);
+	check_priorities(LOW, MEDIUM, HIGH, "chain: MEDIUM's priority is restored");
+	check(gp_current_process == &g_procs[PID_HIGH] && g_mutexes[second].mp_owner == &g_procs[PID_HIGH],
+	      "chain: HIGH runs with the second mutex");
+}
+
+/**
+ * @brief: LOW holds two mutexes, with HIGH waiting on one and MEDIUM on the other.
+ *         Unlocking them must drop LOW's priority one step at a time.
+ */
+static void test_two_held(void)
+{
+	int first;
+	int second;
+
+	reset(PID_LOW);
+	park_all_but(PID_LOW);
+	first = k_create_mutex();
+	second = k_create_mutex();
+	k_lock_mutex(first);
+	k_lock_mutex(second);
+
+	wake(PID_MEDIUM);
+	k_lock_mutex(second);
+	wake(PID_HIGH);
+	k_lock_mutex(first);
+	check_priorities(HIGH, MEDIUM, HIGH, "two held: LOW inherits the highest waiter");
+
+	k_unlock_mutex(first);
+	check_priorities(MEDIUM, MEDIUM, HIGH, "two held: LOW keeps MEDIUM through the other mutex");
+	check(gp_current_process == &g_procs[PID_HIGH], "two held: HIGH runs with the first mutex");
+
+	k_unlock_mutex(first);
+	block();
+	check(gp_current_process == &g_procs[PID_LOW], "two held: LOW runs at MEDIUM once HIGH blocks");
+
+	k_unlock_mutex(second);
+	check_priorities(LOW, MEDIUM, HIGH, "two held: LOW's priority is restored");
+	check(gp_current_process == &g_procs[PID_MEDIUM] && g_mutexes[second].mp_owner == &g_procs[PID_MEDIUM],
+	      "two held: MEDIUM runs with the second mutex");
+}
+
+int main(void)
+{
+	test_inversion();
+	test_chain();
+	test_two_held();
+
+	if (g_failures > 0) {
+		printf("FAIL: %d checks failed\n", g_failures);
+		return 1;
+	}
+	printf("PASS\n");
+	return 0;
+}
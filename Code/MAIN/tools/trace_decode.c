@@ -0,0 +1,167 @@
+/**
+ * @file:   trace_decode.c
+ * @brief:  Host tool that renders a capture of the UART1 debug console as a timeline.
+ *          Trace records (see src/trace.h) are decoded into one line per event, log records
+ *          (see src/log_fmt.h) are formatted with the build's format strings, and any
+ *          debug text between them is passed through with a "| " prefix.
+ *
+ * Build:   cc -o trace_decode trace_decode.c
+ * Usage:   trace_decode [capture file]   (reads stdin if no file is given)
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include "../src/trace.h"
+#include "../src/log_fmt.h"
+
+#define TRACE_RECORD_SIZE 8 /* bytes in a record on the wire */
+
+#define TRACE_NAME_ENTRY(id, name) name,
+static const char* g_event_names[NUM_TRACE_EVENTS] = {
+	TRACE_EVENTS(TRACE_NAME_ENTRY)
+};
+#undef TRACE_NAME_ENTRY
+
+#define LOG_FORMAT_ENTRY(id, format) format,
+static const char* g_log_formats[NUM_LOG_FORMATS] = {
+	LOG_FORMATS(LOG_FORMAT_ENTRY)
+};
+#undef LOG_FORMAT_ENTRY
+
+static int g_in_text = 0; // Whether a line of debug text has been started and not ended
+
+/**
+ * @brief: Passes a byte of debug text through, starting each line with "| "
+ */
+static void put_text(int c)
+{
+	if (c == '\r') {
+		return;
+	}
+	if (!g_in_text) {
+		fputs("| ", stdout);
+		g_in_text = 1;
+	}
+	putchar(c);
+	if (c == '\n') {
+		g_in_text = 0;
+	}
+}
+
+/**
+ * @brief: Prints one decoded record. The 32-bit microsecond timestamps are unwrapped
+ *         into 64 bits, assuming records are less than about 71 minutes apart.
+ */
+static void put_record(const uint8_t* bytes, uint64_t* p_now, int* p_first)
+{
+	uint32_t time = (uint32_t)bytes[4] | ((uint32_t)bytes[5] << 8) | ((uint32_t)bytes[6] << 16) | ((uint32_t)bytes[7] << 24);
+	uint64_t delta = *p_first ? 0 : (uint32_t)(time - (uint32_t)*p_now);
+	
+	*p_now = *p_first ? time : *p_now + delta;
+	*p_first = 0;
+	
+	if (g_in_text) {
+		putchar('\n');
+		g_in_text = 0;
+	}
+	printf("%10llu.%03llu ms  +%-8llu pid %-3u %-14s %u\n",
+	       (unsigned long long)(*p_now / 1000), (unsigned long long)(*p_now % 1000),
+	       (unsigned long long)delta, bytes[2], g_event_names[bytes[1]], bytes[3]);
+}
+
+/**
+ * @brief: Reads a log record after its sync byte and prints its text
+ * @return: 1 if it was a log record, 0 if the bytes read should be passed through as text
+ */
+static int put_log(FILE* in, uint8_t* bytes, int* p_count)
+{
+	uint32_t args[LOG_MAX_ARGS] = { 0, 0, 0 };
+	int count;
+	int c;
+	int i;
+	
+	for (count = 1; count < 4 && (c = fgetc(in)) != EOF; count++) {
+		bytes[count] = (uint8_t)c;
+	}
+	*p_count = count;
+	if (count < 4 || bytes[1] >= NUM_LOG_FORMATS || bytes[2] > LOG_MAX_ARGS) {
+		return 0;
+	}
+	
+	for (; count < 4 + 4 * bytes[2] && (c = fgetc(in)) != EOF; count++) {
+		bytes[count] = (uint8_t)c;
+	}
+	*p_count = count;
+	if (count < 4 + 4 * bytes[2]) {
+		return 0;
+	}
+	
+	for (i = 0; i < bytes[2]; i++) {
+		args[i] = (uint32_t)bytes[4 + 4 * i] | ((uint32_t)bytes[5 + 4 * i] << 8)
+		        | ((uint32_t)bytes[6 + 4 * i] << 16) | ((uint32_t)bytes[7 + 4 * i] << 24);
+	}
+	
+	if (g_in_text) {
+		putchar('\n');
+		g_in_text = 0;
+	}
+	printf("%30s", "log  ");
+	printf(g_log_formats[bytes[1]], args[0], args[1], args[2]);
+	putchar('\n');
+	return 1;
+}
+
+int main(int argc, char* argv[])
+{
+	FILE* in = stdin;
+	uint8_t record[4 + 4 * LOG_MAX_ARGS];
+	uint64_t now = 0;
+	int first = 1;
+	int count = 0;
+	int c;
+	int i;
+	
+	if (argc > 1 && (in = fopen(argv[1], "rb")) == NULL) {
+		perror(argv[1]);
+		return 1;
+	}
+	
+	printf("      time(ms)  delta(us)  pid     event          arg\n");
+	
+	while ((c = fgetc(in)) != EOF) {
+		if (c == LOG_SYNC) {
+			record[0] = (uint8_t)c;
+			if (!put_log(in, record, &count)) {
+				for (i = 1; i < count; i++) {
+					put_text(record[i]);
+				}
+			}
+			continue;
+		}
+		
+		if (c != TRACE_SYNC) {
+			put_text(c);
+			continue;
+		}
+		
+		record[0] = (uint8_t)c;
+		for (count = 1; count < TRACE_RECORD_SIZE && (c = fgetc(in)) != EOF; count++) {
+			record[count] = (uint8_t)c;
+		}
+		
+		// A record with an unknown event is not a record, so pass its bytes through as text
+		if (count < TRACE_RECORD_SIZE || record[1] >= NUM_TRACE_EVENTS) {
+			for (i = 1; i < count; i++) {
+				put_text(record[i]);
+			}
+			continue;
+		}
+		
+		put_record(record, &now, &first);
+	}
+	
+	if (in != stdin) {
+		fclose(in);
+	}
+	return 0;
+}
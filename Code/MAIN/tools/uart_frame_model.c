@@ -0,0 +1,410 @@
+/**
+ * @file:   uart_frame_model.c
+ * @brief:  Host model of framed console input. Bytes go through the real receive path
+ *          (src/uart_rx.c) the way uart_rx_drain feeds it, and what it sends to the KCD is
+ *          handled by the real kcd_handle_message (src/sys_proc.c), whose replies are captured
+ *          from crt_printf. Checks the FRAMED_INPUT payload and the OK/ERR reply for good frames,
+ *          zero length, over-long and null byte payloads, that a client that stops partway
+ *          through a frame is timed out, that a frame arriving while the user is typing
+ *          leaves the line alone, and that frames are never echoed.
+ *
+ * Build:   cc -I host -D'__svc_indirect(x)=' -o uart_frame_model uart_frame_model.c ../src/uart_rx.c ../src/sys_proc.c ../src/utils.c ../src/printf.c
+ * Usage:   uart_frame_model   (prints PASS or each failure, exits non-zero on failure)
+ *
+ * NOTE: On 64-bit hosts, the SVC wrappers warn about casting function pointers to U32.
+ *       The model's wrappers ignore that argument, so the warnings are harmless.
+ */
+
+#include <LPC17xx.h>
+#include "../src/uart.h"
+#include "../src/k_rtx.h"
+#include "../src/uart_rx.h"
+#include <stdio.h>
+#include <string.h>
+
+#define PORT_KCD 1
+#define PORT_CRT 2
+#define PID_WALL 5		/* process that registers %WS with the KCD */
+#define NUM_BLOCKS 16	/* memory blocks available to the model */
+#define SZ_MAILBOX 16	/* messages that can wait for the KCD */
+#define SZ_TEXT 512		/* echoed or displayed characters kept per scenario */
+
+LPC_UART_TypeDef g_fake_uart0;
+volatile uint32_t g_timer_count = 0;
+
+extern void kcd_handle_message(MSG_BUF* message_received, int sender_id);
+
+static MSG_BUF g_blocks[NUM_BLOCKS];
+static int g_block_used[NUM_BLOCKS];
+
+static MSG_BUF* g_kcd_mailbox[SZ_MAILBOX];	// Messages sent to the KCD's port, oldest first
+static int g_kcd_count = 0;
+
+static char g_echo[SZ_TEXT];	// Characters the line discipline wrote to UART0
+static int g_echo_length = 0;
+static char g_crt[SZ_TEXT];		// Text crt_printf sent to the CRT
+static int g_crt_length = 0;
+
+static char g_command[SZ_MTEXT];	// Last command the KCD forwarded
+static int g_command_pid = 0;
+static int g_command_priority = 0;
+
+static int g_failures = 0;
+
+/* Kernel calls made by the UART i-process */
+
+void* ki_request_memory_block(void)
+{
+	int i;
+
+	for (i = 0; i < NUM_BLOCKS; i++) {
+		if (!g_block_used[i]) {
+			g_block_used[i] = 1;
+			memset(&g_blocks[i], 0, sizeof(MSG_BUF));
+			return &g_blocks[i];
+		}
+	}
+	return NULL;
+}
+
+int k_release_memory_block(void* p_mem_blk)
+{
+	int i = (MSG_BUF*)p_mem_blk - g_blocks;
+
+	if (i < 0 || i >= NUM_BLOCKS || !g_block_used[i]) {
+		printf("FAIL: released a block that wasn't in use\n");
+		g_failures++;
+		return RTX_ERR;
+	}
+	g_block_used[i] = 0;
+	return RTX_OK;
+}
+
+int k_lookup_port(const char* name)
+{
+	if (strcmp(name, "KCD") == 0) {
+		return PORT_KCD;
+	}
+	return strcmp(name, "CRT") == 0 ? PORT_CRT : RTX_ERR;
+}
+
+int k_send_to_port(int port_id, void* p_msg)
+{
+	MSG_BUF* message = (MSG_BUF*)p_msg;
+
+	if (port_id == PORT_KCD && g_kcd_count < SZ_MAILBOX) {
+		g_kcd_mailbox[g_kcd_count++] = message;
+		return RTX_OK;
+	}
+	if (port_id == PORT_CRT && g_crt_length + strlen(message->mtext) < SZ_TEXT) {
+		strcpy(g_crt + g_crt_length, message->mtext);
+		g_crt_length += strlen(message->mtext);
+		k_release_memory_block(message);
+		return RTX_OK;
+	}
+	return RTX_ERR;
+}
+
+void uart_tx_write(LPC_UART_TypeDef* pUart, const char* chars, int len)
+{
+	if (g_echo_length + len < SZ_TEXT) {
+		memcpy(g_echo + g_echo_length, chars, len);
+		g_echo_length += len;
+	}
+}
+
+/* Kernel calls made by the KCD and crt_printf */
+
+void* k_request_memory_block(void)
+{
+	return ki_request_memory_block();
+}
+
+int k_send_message(int pid, void* p_msg)
+{
+	strcpy(g_command, ((MSG_BUF*)p_msg)->mtext);
+	g_command_pid = pid;
+	return k_release_memory_block(p_msg);
+}
+
+int k_set_message_priority(void* p_msg, int priority)
+{
+	g_command_priority = priority;
+	return RTX_OK;
+}
+
+/* The KCD and CRT loops are linked in but never run */
+void* k_receive_all_messages(int* p_pid) { return NULL; }
+void* next_message(void* p_msg, int* p_pid) { return NULL; }
+
+/* SVC wrappers, which call the kernel directly instead of trapping */
+
+void* _request_memory_block(U32 p_func) { return k_request_memory_block(); }
+int _release_memory_block(U32 p_func, void* p_mem_blk) { return k_release_memory_block(p_mem_blk); }
+int _lookup_port(U32 p_func, const char* name) { return k_lookup_port(name); }
+int _send_to_port(U32 p_func, int port_id, void* p_msg) { return k_send_to_port(port_id, p_msg); }
+int _send_message(U32 p_func, int pid, void* p_msg) { return k_send_message(pid, p_msg); }
+int _set_message_priority(U32 p_func, void* p_msg, int priority) { return k_set_message_priority(p_msg, priority); }
+void* _receive_all_messages(U32 p_func, void* p_pid) { return NULL; }
+
+/**
+ * @brief: Feeds bytes to the receive path the way uart_rx_drain does
+ */
+static void feed(const char* bytes, int len)
+{
+	int i;
+
+	for (i = 0; i < len; i++) {
+		if (!uart_frame_input(bytes[i])) {
+			uart_line_discipline(LPC_UART0, bytes[i]);
+		}
+	}
+}
+
+/**
+ * @brief: Feeds a frame header for the given length, then the payload
+ */
+static void feed_frame(int length, const char* payload, int payload_len)
+{
+	char header[2];
+
+	header[0] = FRAME_SOF;
+	header[1] = (char)length;
+	feed(header, 2);
+	feed(payload, payload_len);
+}
+
+/**
+ * @brief: Hands the KCD every message sent to its port
+ */
+static void run_kcd(void)
+{
+	int i;
+
+	for (i = 0; i < g_kcd_count; i++) {
+		kcd_handle_message(g_kcd_mailbox[i], PID_UART_IPROC);
+	}
+	g_kcd_count = 0;
+}
+
+/**
+ * @brief: Starts a scenario with nothing typed, no frame in progress and nothing captured
+ */
+static void reset(void)
+{
+	g_timer_count += FRAME_TIMEOUT_MS + 1;	// Times out any frame left over
+	feed("\r", 1);							// Ends any line left over
+	run_kcd();
+	g_echo_length = 0;
+	g_crt_length = 0;
+	g_command[0] = '\0';
+	g_command_pid = 0;
+	g_command_priority = 0;
+}
+
+static void check(int ok, const char* what)
+{
+	if (!ok) {
+		printf("FAIL: %s\n", what);
+		g_failures++;
+	}
+}
+
+/**
+ * @brief: Checks the only message waiting for the KCD
+ */
+static void check_kcd(int mtype, const char* text, const char* what)
+{
+	if (g_kcd_count != 1 || g_kcd_mailbox[0]->mtype != mtype || strcmp(g_kcd_mailbox[0]->mtext, text) != 0) {
+		printf("FAIL: %s: the KCD got %d messages, expected one of type %d with \"%s\"\n",
+		       what, g_kcd_count, mtype, text);
+		g_failures++;
+	}
+}
+
+/**
+ * @brief: Checks the CRT got exactly the given text
+ */
+static void check_crt(const char* text, const char* what)
+{
+	g_crt[g_crt_length] = '\0';
+	if (strcmp(g_crt, text) != 0) {
+		printf("FAIL: %s: the CRT got \"%s\"\n", what, g_crt);
+		g_failures++;
+	}
+}
+
+static const char g_reply_ok[] = { FRAME_SOF, 2, 'O', 'K', '\0' };
+static const char g_reply_err[] = { FRAME_SOF, 3, 'E', 'R', 'R', '\0' };
+
+/**
+ * @brief: A well-formed frame, and one as long as a message can hold, are sent to the KCD
+ *         whole and answered OK
+ */
+static void test_good_frame(void)
+{
+	char payload[SZ_FRAME_PAYLOAD];
+
+	reset();
+	feed_frame(6, "%WS 12", 6);
+	check_kcd(FRAMED_INPUT, "%WS 12", "good frame: the payload is sent");
+	run_kcd();
+	check_crt(g_reply_ok, "good frame: the KCD replies OK");
+	check(g_command_pid == PID_WALL && g_command_priority == HIGH && strcmp(g_command, "%WS 12") == 0,
+	      "good frame: the command is forwarded ahead of data");
+	check(g_echo_length == 0, "good frame: nothing is echoed");
+
+	// A payload as long as a message can hold still fits
+	memset(payload, ' ', sizeof(payload));
+	memcpy(payload, "%WS", 3);
+	reset();
+	feed_frame(SZ_FRAME_PAYLOAD, payload, SZ_FRAME_PAYLOAD);
+	check(g_kcd_count == 1 && strlen(g_kcd_mailbox[0]->mtext) == SZ_FRAME_PAYLOAD, "longest frame: the payload is sent");
+	run_kcd();
+	check_crt(g_reply_ok, "longest frame: the KCD replies OK");
+}
+
+/**
+ * @brief: Frames the KCD can't dispatch are answered ERR, including payloads the receive
+ *         path has to empty: zero length, too long for a message, or containing a null byte
+ */
+static void test_rejected_frames(void)
+{
+	char payload[255];
+
+	reset();
+	feed_frame(3, "%XY", 3);
+	run_kcd();
+	check_crt(g_reply_err, "unregistered command: the KCD replies ERR");
+
+	reset();
+	feed_frame(0, "", 0);
+	check_kcd(FRAMED_INPUT, "", "zero length: an empty payload is sent");
+	run_kcd();
+	check_crt(g_reply_err, "zero length: the KCD replies ERR");
+
+	// Every byte of an over-long payload must be consumed, so the next frame is still found.
+	// %WS would be forwarded if the payload were cut to fit
+	memset(payload, ' ', sizeof(payload));
+	memcpy(payload, "%WS", 3);
+	reset();
+	feed_frame(SZ_FRAME_PAYLOAD + 1, payload, SZ_FRAME_PAYLOAD + 1);
+	check_kcd(FRAMED_INPUT, "", "over-long: an empty payload is sent");
+	run_kcd();
+	check_crt(g_reply_err, "over-long: the KCD replies ERR");
+	g_crt_length = 0;
+	feed_frame(sizeof(payload), payload, sizeof(payload));
+	check_kcd(FRAMED_INPUT, "", "longest length byte: an empty payload is sent");
+	run_kcd();
+	check_crt(g_reply_err, "longest length byte: the KCD replies ERR");
+	g_crt_length = 0;
+	feed_frame(3, "%WS", 3);
+	check_kcd(FRAMED_INPUT, "%WS", "over-long: the next frame is received");
+	run_kcd();
+	check_crt(g_reply_ok, "over-long: the next frame is answered OK");
+	check(g_echo_length == 0, "over-long: nothing is echoed");
+
+	// %WS would be forwarded if the payload were cut at the null byte
+	reset();
+	feed_frame(6, "%WS\0 1", 6);
+	check_kcd(FRAMED_INPUT, "", "null byte: an empty payload is sent");
+	run_kcd();
+	check_crt(g_reply_err, "null byte: the KCD replies ERR");
+	feed("\r", 1);
+	check(g_kcd_count == 0, "null byte: no payload bytes reach the line discipline");
+}
+
+/**
+ * @brief: A frame that stops arriving for more than FRAME_TIMEOUT_MS is abandoned, one that
+ *         keeps arriving is not, even across the clock wrapping
+ */
+static void test_timeout(void)
+{
+	reset();
+	feed_frame(6, "%WS", 3);
+	g_timer_count += FRAME_TIMEOUT_MS;
+	feed(" 1", 2);
+	g_timer_count += FRAME_TIMEOUT_MS;
+	feed("2", 1);
+	check_kcd(FRAMED_INPUT, "%WS 12", "slow frame: a frame that keeps arriving isn't timed out");
+	run_kcd();
+
+	reset();
+	feed_frame(6, "%WS", 3);
+	g_timer_count += FRAME_TIMEOUT_MS + 1;
+	feed("ab\r", 3);
+	check_kcd(USER_INPUT, "ab", "timeout: typing resumes after an abandoned frame");
+	check(g_echo_length == 4 && memcmp(g_echo, "ab\r\n", 4) == 0, "timeout: the typing is echoed");
+	run_kcd();
+
+	// The clock wrapping partway through a frame doesn't time it out
+	reset();
+	g_timer_count = 0xFFFFFFFF - FRAME_TIMEOUT_MS / 2;
+	feed_frame(3, "%W", 2);
+	g_timer_count += FRAME_TIMEOUT_MS;
+	feed("S", 1);
+	check_kcd(FRAMED_INPUT, "%WS", "wrap: the frame is received across the wrap");
+	run_kcd();
+
+	// Abandoned just after its header
+	reset();
+	feed_frame(6, "", 0);
+	g_timer_count += FRAME_TIMEOUT_MS + 1;
+	feed_frame(3, "%WS", 3);
+	check_kcd(FRAMED_INPUT, "%WS", "timeout: a new frame starts after an abandoned header");
+	run_kcd();
+	check_crt(g_reply_ok, "timeout: the new frame is answered OK");
+}
+
+/**
+ * @brief: A frame arriving in the middle of a typed line, and STX typed by the user
+ */
+static void test_interleaved(void)
+{
+	reset();
+	feed("%W", 2);
+	feed_frame(3, "%WS", 3);
+	check_kcd(FRAMED_INPUT, "%WS", "interleaved: the frame is received while the user types");
+	run_kcd();
+	check_crt(g_reply_ok, "interleaved: the frame is answered OK");
+	feed("S 5\r", 4);
+	check_kcd(USER_INPUT, "%WS 5", "interleaved: the typed line is unchanged");
+	check(g_echo_length == 7 && memcmp(g_echo, "%WS 5\r\n", 7) == 0, "interleaved: only the typing is echoed");
+	run_kcd();
+
+	// STX typed partway through a line starts a frame, so the next byte is its length
+	reset();
+	feed("a\002\001b", 4);
+	check_kcd(FRAMED_INPUT, "b", "typed STX: it starts a frame");
+	run_kcd();
+	feed("\r", 1);
+	check_kcd(USER_INPUT, "a", "typed STX: the line before it is kept");
+	run_kcd();
+}
+
+int main(void)
+{
+	MSG_BUF* registration = (MSG_BUF*)ki_request_memory_block();
+	int i;
+
+	registration->mtype = KCD_REG;
+	strcpy(registration->mtext, "%WS");
+	kcd_handle_message(registration, PID_WALL);
+
+	test_good_frame();
+	test_rejected_frames();
+	test_timeout();
+	test_interleaved();
+
+	reset();
+	for (i = 0; i < NUM_BLOCKS; i++) {
+		check(!g_block_used[i], "every memory block is released");
+	}
+
+	if (g_failures > 0) {
+		printf("FAIL: %d checks failed\n", g_failures);
+		return 1;
+	}
+	printf("PASS\n");
+	return 0;
+}
@@ -0,0 +1,164 @@
+/**
+ * @file:   uart_tx_model.c
+ * @brief:  Host model of the UART0 transmit path (src/uart_tx.c). The real ring buffer and
+ *          fill logic drive a fake 16 byte TX FIFO and THRE interrupt, while bursts of long
+ *          CRT_DISPLAY messages are delivered at random times. Checks that every character
+ *          comes out on the wire once and in order, that the FIFO never overflows, that every
+ *          message is released once, and that THRE is turned off when there is nothing to send.
+ *
+ * Build:   cc -I host -o uart_tx_model uart_tx_model.c ../src/uart_tx.c ../src/ring_buffer.c
+ * Usage:   uart_tx_model [seed]   (prints PASS or the first failure, exits non-zero on failure)
+ */
+
+#include <LPC17xx.h>
+#include "../src/uart.h"
+#include "../src/k_rtx.h"
+#include "../src/uart_tx.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NUM_MESSAGES 2000	/* CRT_DISPLAY messages sent over the whole run */
+#define MAX_BURST 12		/* most messages delivered at once */
+#define SZ_MAILBOX 4096		/* messages that can wait for the UART i-process */
+#define SZ_WIRE (NUM_MESSAGES * SZ_MTEXT)
+
+LPC_UART_TypeDef g_fake_uart0;
+
+static int g_fifo_head = 0;		// Slot of the next character to shift out
+static int g_fifo_count = 0;	// Characters in the TX FIFO
+static int g_fifo_overflows = 0;
+
+static MSG_BUF* g_mailbox[SZ_MAILBOX];	// Messages waiting for the UART i-process, oldest first
+static int g_mailbox_head = 0;
+static int g_mailbox_count = 0;
+static int g_released = 0;
+
+static char g_sent[SZ_WIRE];	// Every character handed to the UART i-process, in order
+static int g_sent_length = 0;
+static char g_wire[SZ_WIRE];	// Every character shifted out of the TX FIFO
+static int g_wire_length = 0;
+
+int fake_uart_thr_slot(void)
+{
+	int slot = (g_fifo_head + g_fifo_count) % sizeof(g_fake_uart0.fifo);
+
+	if (g_fifo_count == sizeof(g_fake_uart0.fifo)) {
+		g_fifo_overflows++;
+		return slot;
+	}
+	g_fifo_count++;
+	return slot;
+}
+
+void* ki_receive_message(int* p_pid)
+{
+	MSG_BUF* message;
+
+	if (g_mailbox_count == 0) {
+		return NULL;
+	}
+	message = g_mailbox[g_mailbox_head];
+	g_mailbox_head = (g_mailbox_head + 1) % SZ_MAILBOX;
+	g_mailbox_count--;
+	return message;
+}
+
+int k_release_memory_block(void* p_mem_blk)
+{
+	MSG_BUF* message = (MSG_BUF*)p_mem_blk;
+
+	if (message->mtype != CRT_DISPLAY) {
+		fprintf(stderr, "FAIL: message released twice\n");
+		exit(1);
+	}
+	message->mtype = DEFAULT;
+	g_released++;
+	free(message);
+	return RTX_OK;
+}
+
+/**
+ * @brief: Delivers a CRT_DISPLAY message of random length to the UART i-process, like deliver_message
+ */
+static void send_crt_message(void)
+{
+	MSG_BUF* message = (MSG_BUF*)malloc(sizeof(int) + SZ_MTEXT);
+	int length = 1 + rand() % (SZ_MTEXT - 1);
+	int i;
+
+	message->mtype = CRT_DISPLAY;
+	for (i = 0; i < length; i++) {
+		message->mtext[i] = ' ' + (g_sent_length + i) % 95; // printable, and different from its neighbours
+	}
+	message->mtext[length] = '\0';
+	memcpy(g_sent + g_sent_length, message->mtext, length);
+	g_sent_length += length;
+
+	g_mailbox[(g_mailbox_head + g_mailbox_count) % SZ_MAILBOX] = message;
+	g_mailbox_count++;
+	uart_tx_start();
+}
+
+/**
+ * @brief: Runs the THRE branch of the UART i-process if the interrupt is enabled and the FIFO is empty
+ */
+static void run_thre_interrupt(void)
+{
+	if ((g_fake_uart0.IER & IER_THRE) && g_fifo_count == 0) {
+		uart_tx_load_messages();
+		uart_tx_fill(&g_fake_uart0);
+	}
+}
+
+/**
+ * @brief: Shifts one character out of the TX FIFO onto the wire
+ */
+static void shift_out(void)
+{
+	if (g_fifo_count > 0) {
+		g_wire[g_wire_length++] = g_fake_uart0.fifo[g_fifo_head];
+		g_fifo_head = (g_fifo_head + 1) % sizeof(g_fake_uart0.fifo);
+		g_fifo_count--;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	int num_sent = 0;
+	int burst;
+	int i;
+
+	srand(argc > 1 ? atoi(argv[1]) : 1);
+	uart_tx_init();
+
+	while (num_sent < NUM_MESSAGES || g_mailbox_count > 0 || g_fifo_count > 0 || (g_fake_uart0.IER & IER_THRE)) {
+		// Now and then the CRT delivers a burst of messages, often more than the TX buffer holds
+		if (num_sent < NUM_MESSAGES && rand() % 200 == 0) {
+			burst = 1 + rand() % MAX_BURST;
+			for (i = 0; i < burst && num_sent < NUM_MESSAGES; i++, num_sent++) {
+				send_crt_message();
+			}
+		}
+		run_thre_interrupt();
+		shift_out();
+	}
+
+	if (g_fifo_overflows > 0) {
+		printf("FAIL: the TX FIFO overflowed %d times\n", g_fifo_overflows);
+		return 1;
+	}
+	if (g_released != NUM_MESSAGES) {
+		printf("FAIL: %d of %d messages were released\n", g_released, NUM_MESSAGES);
+		return 1;
+	}
+	if (g_wire_length != g_sent_length || memcmp(g_wire, g_sent, g_sent_length) != 0) {
+		for (i = 0; i < g_wire_length && i < g_sent_length && g_wire[i] == g_sent[i]; i++) {
+		}
+		printf("FAIL: sent %d characters, %d came out, first difference at %d\n", g_sent_length, g_wire_length, i);
+		return 1;
+	}
+
+	printf("PASS: %d messages, %d characters\n", NUM_MESSAGES, g_sent_length);
+	return 0;
+}